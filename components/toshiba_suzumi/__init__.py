@@ -0,0 +1,55 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import sensor
+from esphome.const import (
+    CONF_ID,
+    CONF_POWER,
+    DEVICE_CLASS_POWER,
+    STATE_CLASS_MEASUREMENT,
+    UNIT_PERCENT,
+    UNIT_WATT,
+)
+
+# Optional hub shared by indoor units of one outdoor unit (multi-split), see outdoor_unit_id of the climate
+MULTI_CONF = True
+AUTO_LOAD = ["sensor"]
+
+CONF_LOAD = "load"
+# ToshibaOutdoorUnit::MAX_UNITS
+OUTDOOR_UNIT_MAX_UNITS = 8
+
+toshiba_ns = cg.esphome_ns.namespace("toshiba_suzumi")
+ToshibaOutdoorUnit = toshiba_ns.class_("ToshibaOutdoorUnit", cg.Component)
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ToshibaOutdoorUnit),
+        cv.Optional(CONF_LOAD): sensor.sensor_schema(
+            unit_of_measurement=UNIT_PERCENT,
+            accuracy_decimals=1,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_POWER): sensor.sensor_schema(
+            unit_of_measurement=UNIT_WATT,
+            accuracy_decimals=1,
+            device_class=DEVICE_CLASS_POWER,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    cg.add_define("USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT")
+
+    if CONF_LOAD in config:
+        sens = await sensor.new_sensor(config[CONF_LOAD])
+        cg.add(var.set_load_sensor(sens))
+
+    if CONF_POWER in config:
+        # estimated from the energy counters of the leading indoor unit
+        cg.add_define("USE_TOSHIBA_SUZUMI_ENERGY")
+        sens = await sensor.new_sensor(config[CONF_POWER])
+        cg.add(var.set_power_sensor(sens))
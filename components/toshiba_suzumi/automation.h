@@ -0,0 +1,93 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "toshiba_climate.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+#ifdef USE_TOSHIBA_SUZUMI_RAW_REGISTER
+/// Fired with register and value when the reply to read_register/write_register arrives.
+class RegisterValueTrigger : public Trigger<uint8_t, uint8_t> {
+ public:
+  explicit RegisterValueTrigger(ToshibaClimateUart *parent) {
+    parent->add_on_register_value_callback([this](uint8_t reg, uint8_t value) { this->trigger(reg, value); });
+  }
+};
+
+template<typename... Ts> class ReadRegisterAction : public Action<Ts...>, public Parented<ToshibaClimateUart> {
+ public:
+  TEMPLATABLE_VALUE(uint8_t, reg)
+
+  void play(Ts... x) override { this->parent_->read_register(this->reg_.value(x...)); }
+};
+
+template<typename... Ts> class WriteRegisterAction : public Action<Ts...>, public Parented<ToshibaClimateUart> {
+ public:
+  TEMPLATABLE_VALUE(uint8_t, reg)
+  TEMPLATABLE_VALUE(uint8_t, value)
+
+  void play(Ts... x) override { this->parent_->write_register(this->reg_.value(x...), this->value_.value(x...)); }
+};
+#endif
+
+#ifdef USE_TOSHIBA_SUZUMI_REGISTER_TRIGGERS
+/// Fired with register, new and previous value when the value of the register changes.
+/// On the first report after boot the previous value is the same as the new one.
+class RegisterChangeTrigger : public Trigger<uint8_t, uint8_t, uint8_t> {
+ public:
+  RegisterChangeTrigger(ToshibaClimateUart *parent, uint8_t reg) : reg_(reg) {
+    parent->add_on_register_callback([this](uint8_t reg, uint8_t value) {
+      if (reg != this->reg_ || (this->known_ && value == this->value_)) {
+        return;
+      }
+      uint8_t previous = this->known_ ? this->value_ : value;
+      this->value_ = value;
+      this->known_ = true;
+      this->trigger(reg, value, previous);
+    });
+  }
+
+ protected:
+  uint8_t reg_;
+  uint8_t value_ = 0;
+  bool known_ = false;
+};
+
+/// Fired with register, frame data and length for every decoded frame, optionally only for one register.
+class FrameTrigger : public Trigger<uint8_t, const uint8_t *, uint8_t> {
+ public:
+  FrameTrigger(ToshibaClimateUart *parent, int16_t reg) {
+    parent->add_on_frame_callback([this, reg](uint8_t frame_reg, const uint8_t *data, uint8_t length) {
+      if (reg < 0 || reg == frame_reg) {
+        this->trigger(frame_reg, data, length);
+      }
+    });
+  }
+};
+#endif
+
+#ifdef USE_TOSHIBA_SUZUMI_CAPTURE
+template<typename... Ts> class StartCaptureAction : public Action<Ts...>, public Parented<ToshibaClimateUart> {
+ public:
+  TEMPLATABLE_VALUE(uint32_t, duration)
+  TEMPLATABLE_VALUE(uint32_t, interval)
+
+  void play(Ts... x) override {
+    this->parent_->start_capture(this->duration_.value(x...), this->interval_.value(x...));
+  }
+};
+
+template<typename... Ts> class StopCaptureAction : public Action<Ts...>, public Parented<ToshibaClimateUart> {
+ public:
+  void play(Ts... x) override { this->parent_->stop_capture(); }
+};
+
+template<typename... Ts> class ExportCaptureAction : public Action<Ts...>, public Parented<ToshibaClimateUart> {
+ public:
+  void play(Ts... x) override { this->parent_->export_capture(); }
+};
+#endif
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
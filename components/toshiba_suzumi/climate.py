@@ -1,8 +1,11 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
+import esphome.final_validate as fv
+from esphome import automation
 from esphome.components import binary_sensor, sensor, climate, uart, select
 from esphome.const import (
     CONF_ID,
+    CONF_PLATFORM,
     STATE_CLASS_MEASUREMENT,
     UNIT_CELSIUS,
     UNIT_PERCENT,
@@ -12,14 +15,26 @@ from esphome.const import (
     DEVICE_CLASS_TEMPERATURE,
     DEVICE_CLASS_CURRENT,
     DEVICE_CLASS_RUNNING,
+    DEVICE_CLASS_CONNECTIVITY,
     DEVICE_CLASS_ENERGY,
     DEVICE_CLASS_POWER,
     CONF_TIME_ID,
+    CONF_TRIGGER_ID,
+    CONF_VALUE,
+    CONF_UPDATE_INTERVAL,
     STATE_CLASS_TOTAL_INCREASING,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    UNIT_MILLISECOND,
+    UNIT_MICROSECOND,
+    PLATFORM_ESP32,
+    PLATFORM_HOST,
     __version__ as ESPHOME_VERSION
 )
+from esphome.core import CORE
+from . import ToshibaOutdoorUnit, OUTDOOR_UNIT_MAX_UNITS
 from packaging import version
 import logging
+import os
 
 _LOGGER = logging.getLogger(__name__)
 
@@ -43,22 +58,122 @@ CONF_SPECIAL_MODE = "special_mode" # deprecated - replaced by CONF_SUPPORTED_PRE
 CONF_SPECIAL_MODE_MODES = "modes" # deprecated - replaced by CONF_SUPPORTED_PRESETS
 CONF_SUPPORTED_PRESETS = "supported_presets"
 CONF_SELF_CLEAN = "self_clean"
+CONF_CONNECTED = "connected"
 CONF_TIME_SYNC_INTERVAL = "time_sync_interval"
 CONF_ENERGY = "energy"
 CONF_POWER = "power"
+CONF_LIFETIME_ENERGY = "lifetime_energy"
+CONF_LINK_STATS = "link_stats"
+CONF_LATENCY_REPORT = "latency_report"
+CONF_LOOP_BUDGET = "loop_budget"
+CONF_PACKED_WRITES = "packed_writes"
+CONF_FORCE_WRITES = "force_writes"
+CONF_OUTDOOR_UNIT_ID = "outdoor_unit_id"
+CONF_RX_TASK = "rx_task"
+CONF_PROFILE = "profile"
+CONF_DURATION = "duration"
+CONF_INTERVAL = "interval"
+CONF_SIZE_REPORT = "size_report"
+CONF_ON_REGISTER_VALUE = "on_register_value"
+CONF_REGISTER = "register"
+CONF_ON_REGISTER_CHANGE = "on_register_change"
+CONF_ON_FRAME = "on_frame"
 
 FEATURE_HORIZONTAL_SWING = "horizontal_swing"
 MIN_TEMP = "min_temp"
 DISABLE_HEAT_MODE = "disable_heat_mode"
 DISABLE_WIFI_LED = "disable_wifi_led"
 
+# Optional features compiled only when some unit on the node configures them: define -> YAML keys
+FEATURES = {
+    "USE_TOSHIBA_SUZUMI_INDOOR_TEMP": [CONF_INDOOR_TEMP],
+    "USE_TOSHIBA_SUZUMI_OUTDOOR_TEMP": [CONF_OUTDOOR_TEMP],
+    "USE_TOSHIBA_SUZUMI_ODU_STATUS": [CONF_CDU_TD_TEMP, CONF_CDU_TS_TEMP, CONF_CDU_TE_TEMP, CONF_CDU_LOAD, CONF_CDU_IAC],
+    "USE_TOSHIBA_SUZUMI_IDU_STATUS": [CONF_FCU_TC_TEMP, CONF_FCU_TCJ_TEMP, CONF_FCU_FAN_RPM],
+    "USE_TOSHIBA_SUZUMI_TIME_SYNC": [CONF_TIME_ID],
+    "USE_TOSHIBA_SUZUMI_ENERGY": [CONF_ENERGY, CONF_POWER, CONF_LIFETIME_ENERGY],
+    "USE_TOSHIBA_SUZUMI_PWR_SELECT": [CONF_PWR_SELECT],
+    "USE_TOSHIBA_SUZUMI_VERTICAL_AIR_DIRECTION": [CONF_VERTICAL_AIR_DIRECTION],
+    "USE_TOSHIBA_SUZUMI_SELF_CLEAN": [CONF_SELF_CLEAN],
+    "USE_TOSHIBA_SUZUMI_CONNECTED": [CONF_CONNECTED],
+    "USE_TOSHIBA_SUZUMI_LINK_STATS": [CONF_LINK_STATS],
+    "USE_TOSHIBA_SUZUMI_LATENCY_REPORT": [CONF_LATENCY_REPORT],
+    "USE_TOSHIBA_SUZUMI_RAW_REGISTER": [CONF_ON_REGISTER_VALUE],
+    "USE_TOSHIBA_SUZUMI_REGISTER_TRIGGERS": [CONF_ON_REGISTER_CHANGE, CONF_ON_FRAME],
+    "USE_TOSHIBA_SUZUMI_PROFILE": [CONF_PROFILE],
+    "USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT": [CONF_OUTDOOR_UNIT_ID],
+}
+
+# PlatformIO post-build script printing flash/RAM used by the component per feature
+SIZE_REPORT_SCRIPT = os.path.join(os.path.dirname(__file__), "size_report.py")
+
 toshiba_ns = cg.esphome_ns.namespace("toshiba_suzumi")
 ToshibaClimateUart = toshiba_ns.class_("ToshibaClimateUart", cg.PollingComponent, climate.Climate, uart.UARTDevice)
 ToshibaPwrModeSelect = toshiba_ns.class_('ToshibaPwrModeSelect', select.Select)
 ToshibaSpecialModeSelect = toshiba_ns.class_('ToshibaSpecialModeSelect', select.Select)
 ToshibaVerticalAirDirectionSelect = toshiba_ns.class_('ToshibaVerticalAirDirectionSelect', select.Select)
+LinkStat = toshiba_ns.enum("LinkStat", is_class=True)
+RegisterValueTrigger = toshiba_ns.class_("RegisterValueTrigger", automation.Trigger.template(cg.uint8, cg.uint8))
+ReadRegisterAction = toshiba_ns.class_("ReadRegisterAction", automation.Action)
+WriteRegisterAction = toshiba_ns.class_("WriteRegisterAction", automation.Action)
+StartCaptureAction = toshiba_ns.class_("StartCaptureAction", automation.Action)
+StopCaptureAction = toshiba_ns.class_("StopCaptureAction", automation.Action)
+ExportCaptureAction = toshiba_ns.class_("ExportCaptureAction", automation.Action)
+RegisterChangeTrigger = toshiba_ns.class_(
+    "RegisterChangeTrigger", automation.Trigger.template(cg.uint8, cg.uint8, cg.uint8)
+)
+FrameTrigger = toshiba_ns.class_(
+    "FrameTrigger", automation.Trigger.template(cg.uint8, cg.uint8.operator("const").operator("ptr"), cg.uint8)
+)
+
+# link statistics sensors: YAML key -> (LinkStat value, sensor schema arguments)
+_COUNTER = dict(accuracy_decimals=0, state_class=STATE_CLASS_TOTAL_INCREASING, entity_category=ENTITY_CATEGORY_DIAGNOSTIC)
+_GAUGE = dict(accuracy_decimals=0, state_class=STATE_CLASS_MEASUREMENT, entity_category=ENTITY_CATEGORY_DIAGNOSTIC)
+_LATENCY = dict(_GAUGE, unit_of_measurement=UNIT_MILLISECOND)
+_LOOP_TIME = dict(_GAUGE, unit_of_measurement=UNIT_MICROSECOND)
+LINK_STATS = {
+    "frames_sent": (LinkStat.FRAMES_SENT, _COUNTER),
+    "frames_received": (LinkStat.FRAMES_RECEIVED, _COUNTER),
+    "checksum_errors": (LinkStat.CHECKSUM_ERRORS, _COUNTER),
+    "rx_timeouts": (LinkStat.RX_TIMEOUTS, _COUNTER),
+    "unknown_frames": (LinkStat.UNKNOWN_FRAMES, _COUNTER),
+    "queue_depth": (LinkStat.QUEUE_DEPTH, _GAUGE),
+    "queue_high_watermark": (LinkStat.QUEUE_HIGH_WATERMARK, _GAUGE),
+    "command_wait_p50": (LinkStat.COMMAND_WAIT_P50, _LATENCY),
+    "command_wait_p95": (LinkStat.COMMAND_WAIT_P95, _LATENCY),
+    "round_trip_p50": (LinkStat.ROUND_TRIP_P50, _LATENCY),
+    "round_trip_p95": (LinkStat.ROUND_TRIP_P95, _LATENCY),
+    "peak_loop_time": (LinkStat.PEAK_LOOP_TIME, _LOOP_TIME),
+    "reconnects": (LinkStat.RECONNECTS, _COUNTER),
+    "control_to_wire_p50": (LinkStat.CONTROL_TO_WIRE_P50, _LATENCY),
+    "control_to_wire_p99": (LinkStat.CONTROL_TO_WIRE_P99, _LATENCY),
+    "control_to_confirm_p50": (LinkStat.CONTROL_TO_CONFIRM_P50, _LATENCY),
+    "control_to_confirm_p99": (LinkStat.CONTROL_TO_CONFIRM_P99, _LATENCY),
+    "unsolicited_frames": (LinkStat.UNSOLICITED_FRAMES, _COUNTER),
+    "elided_writes": (LinkStat.ELIDED_WRITES, _COUNTER),
+}
+
+LINK_STATS_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_UPDATE_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+        **{cv.Optional(key): sensor.sensor_schema(**args) for key, (_, args) in LINK_STATS.items()},
+    }
+)
+
+
+def _validate_latency_report(config):
+    # logged with each publish of the link stats, both cover the same period
+    link_stats = config.get(CONF_LINK_STATS)
+    if CONF_LATENCY_REPORT in config and link_stats is not None:
+        if config[CONF_LATENCY_REPORT] != link_stats[CONF_UPDATE_INTERVAL]:
+            raise cv.Invalid(
+                f"With link_stats, {CONF_LATENCY_REPORT} must be its {CONF_UPDATE_INTERVAL}",
+                path=[CONF_LATENCY_REPORT],
+            )
+    return config
+
 
-CONFIG_SCHEMA = climate.climate_schema(ToshibaClimateUart).extend(
+CONFIG_SCHEMA = cv.All(climate.climate_schema(ToshibaClimateUart).extend(
     {
         cv.GenerateID(): cv.declare_id(ToshibaClimateUart),
         cv.Optional(CONF_INDOOR_TEMP): sensor.sensor_schema(
@@ -147,14 +262,71 @@ CONFIG_SCHEMA = climate.climate_schema(ToshibaClimateUart).extend(
                 device_class=DEVICE_CLASS_ENERGY,
                 state_class=STATE_CLASS_TOTAL_INCREASING,
             ),
+        cv.Optional(CONF_LIFETIME_ENERGY): sensor.sensor_schema(
+                unit_of_measurement=UNIT_WATT_HOURS,
+                accuracy_decimals=0,
+                device_class=DEVICE_CLASS_ENERGY,
+                state_class=STATE_CLASS_TOTAL_INCREASING,
+            ),
         cv.Optional(CONF_POWER): sensor.sensor_schema(
                 unit_of_measurement=UNIT_WATT,
                 accuracy_decimals=1,
                 device_class=DEVICE_CLASS_POWER,
                 state_class=STATE_CLASS_MEASUREMENT,
             ),
+        cv.Optional(CONF_CONNECTED): binary_sensor.binary_sensor_schema(
+                device_class=DEVICE_CLASS_CONNECTIVITY,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            ),
+        cv.Optional(CONF_LINK_STATS): LINK_STATS_SCHEMA,
+        cv.Optional(CONF_LATENCY_REPORT): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_LOOP_BUDGET, default="2000us"): cv.positive_time_period_microseconds,
+        cv.Optional(CONF_PACKED_WRITES, default=False): cv.boolean,
+        cv.Optional(CONF_FORCE_WRITES, default=False): cv.boolean,
+        cv.Optional(CONF_OUTDOOR_UNIT_ID): cv.use_id(ToshibaOutdoorUnit),
+        cv.Optional(CONF_PROFILE): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_RX_TASK): cv.All(cv.boolean, cv.only_on([PLATFORM_ESP32, PLATFORM_HOST])),
+        cv.Optional(CONF_SIZE_REPORT, default=False): cv.boolean,
+        cv.Optional(CONF_ON_REGISTER_VALUE): automation.validate_automation(
+            {
+                cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(RegisterValueTrigger),
+            }
+        ),
+        cv.Optional(CONF_ON_REGISTER_CHANGE): automation.validate_automation(
+            {
+                cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(RegisterChangeTrigger),
+                cv.Required(CONF_REGISTER): cv.uint8_t,
+            }
+        ),
+        cv.Optional(CONF_ON_FRAME): automation.validate_automation(
+            {
+                cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(FrameTrigger),
+                cv.Optional(CONF_REGISTER): cv.uint8_t,
+            }
+        ),
     }
-).extend(uart.UART_DEVICE_SCHEMA).extend(cv.polling_component_schema("120s"))
+).extend(uart.UART_DEVICE_SCHEMA).extend(cv.polling_component_schema("120s")), _validate_latency_report)
+
+def _validate_outdoor_unit_units(config):
+    # the hub has room for a fixed number of indoor units, further ones would run standalone
+    if CONF_OUTDOOR_UNIT_ID not in config:
+        return config
+    units = [
+        conf
+        for conf in fv.full_config.get().get("climate", [])
+        if conf.get(CONF_PLATFORM) == "toshiba_suzumi"
+        and conf.get(CONF_OUTDOOR_UNIT_ID) == config[CONF_OUTDOOR_UNIT_ID]
+    ]
+    if len(units) > OUTDOOR_UNIT_MAX_UNITS:
+        raise cv.Invalid(
+            f"At most {OUTDOOR_UNIT_MAX_UNITS} indoor units can share an outdoor unit, "
+            f"{len(units)} use '{config[CONF_OUTDOOR_UNIT_ID]}'",
+            path=[CONF_OUTDOOR_UNIT_ID],
+        )
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = _validate_outdoor_unit_units
 
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
@@ -162,6 +334,16 @@ async def to_code(config):
     await climate.register_climate(var, config)
     await uart.register_uart_device(var, config)
 
+    for define, keys in FEATURES.items():
+        if any(key in config for key in keys):
+            cg.add_define(define)
+
+    if config[CONF_SIZE_REPORT]:
+        scripts = CORE.platformio_options.get("extra_scripts", [])
+        script = f"post:{SIZE_REPORT_SCRIPT}"
+        if script not in scripts:
+            cg.add_platformio_option("extra_scripts", [*scripts, script])
+
     if CONF_INDOOR_TEMP in config:
         conf = config[CONF_INDOOR_TEMP]
         sens = await sensor.new_sensor(conf)
@@ -217,6 +399,10 @@ async def to_code(config):
         sens = await binary_sensor.new_binary_sensor(config[CONF_SELF_CLEAN])
         cg.add(var.set_self_clean_sensor(sens))
 
+    if CONF_CONNECTED in config:
+        sens = await binary_sensor.new_binary_sensor(config[CONF_CONNECTED])
+        cg.add(var.set_connected_sensor(sens))
+
     if FEATURE_HORIZONTAL_SWING in config:
         cg.add(var.set_horizontal_swing(True))
 
@@ -248,8 +434,6 @@ async def to_code(config):
     if CONF_TIME_ID in config:
         time_ = await cg.get_variable(config[CONF_TIME_ID])
         cg.add(var.set_time(time_))
-
-    if CONF_TIME_SYNC_INTERVAL in config:
         cg.add(var.set_time_sync_interval(config[CONF_TIME_SYNC_INTERVAL]))
 
     if CONF_ENERGY in config:
@@ -259,3 +443,123 @@ async def to_code(config):
     if CONF_POWER in config:
         sens = await sensor.new_sensor(config[CONF_POWER])
         cg.add(var.set_power_sensor(sens))
+
+    if CONF_LIFETIME_ENERGY in config:
+        sens = await sensor.new_sensor(config[CONF_LIFETIME_ENERGY])
+        cg.add(var.set_lifetime_energy_sensor(sens))
+
+    cg.add(var.set_loop_budget(config[CONF_LOOP_BUDGET]))
+    if config[CONF_PACKED_WRITES]:
+        cg.add(var.set_packed_writes(True))
+    if config[CONF_FORCE_WRITES]:
+        cg.add(var.set_force_writes(True))
+    if CONF_OUTDOOR_UNIT_ID in config:
+        outdoor_unit = await cg.get_variable(config[CONF_OUTDOOR_UNIT_ID])
+        cg.add(var.set_outdoor_unit(outdoor_unit))
+    if CONF_PROFILE in config:
+        cg.add(var.set_profile_interval(config[CONF_PROFILE]))
+    if config.get(CONF_RX_TASK):
+        cg.add_define("USE_TOSHIBA_SUZUMI_RX_TASK")
+        cg.add(var.set_rx_task(True))
+
+    if CONF_LINK_STATS in config:
+        conf = config[CONF_LINK_STATS]
+        cg.add(var.set_link_stats_interval(conf[CONF_UPDATE_INTERVAL]))
+        for key, (stat, _) in LINK_STATS.items():
+            if key in conf:
+                sens = await sensor.new_sensor(conf[key])
+                cg.add(var.set_link_stats_sensor(stat, sens))
+    if CONF_LATENCY_REPORT in config:
+        cg.add(var.set_latency_report_interval(config[CONF_LATENCY_REPORT]))
+
+    for conf in config.get(CONF_ON_REGISTER_VALUE, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(cg.uint8, "reg"), (cg.uint8, "value")], conf)
+
+    for conf in config.get(CONF_ON_REGISTER_CHANGE, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var, conf[CONF_REGISTER])
+        await automation.build_automation(
+            trigger, [(cg.uint8, "reg"), (cg.uint8, "value"), (cg.uint8, "previous")], conf
+        )
+
+    for conf in config.get(CONF_ON_FRAME, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var, conf.get(CONF_REGISTER, -1))
+        await automation.build_automation(
+            trigger,
+            [(cg.uint8, "reg"), (cg.uint8.operator("const").operator("ptr"), "data"), (cg.uint8, "length")],
+            conf,
+        )
+
+
+READ_REGISTER_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(ToshibaClimateUart),
+        cv.Required(CONF_REGISTER): cv.templatable(cv.uint8_t),
+    }
+)
+
+WRITE_REGISTER_SCHEMA = READ_REGISTER_SCHEMA.extend(
+    {
+        cv.Required(CONF_VALUE): cv.templatable(cv.uint8_t),
+    }
+)
+
+
+@automation.register_action("toshiba_suzumi.read_register", ReadRegisterAction, READ_REGISTER_SCHEMA)
+async def read_register_to_code(config, action_id, template_arg, args):
+    cg.add_define("USE_TOSHIBA_SUZUMI_RAW_REGISTER")
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    cg.add(var.set_reg(await cg.templatable(config[CONF_REGISTER], args, cg.uint8)))
+    return var
+
+
+@automation.register_action("toshiba_suzumi.write_register", WriteRegisterAction, WRITE_REGISTER_SCHEMA)
+async def write_register_to_code(config, action_id, template_arg, args):
+    cg.add_define("USE_TOSHIBA_SUZUMI_RAW_REGISTER")
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    cg.add(var.set_reg(await cg.templatable(config[CONF_REGISTER], args, cg.uint8)))
+    cg.add(var.set_value(await cg.templatable(config[CONF_VALUE], args, cg.uint8)))
+    return var
+
+
+START_CAPTURE_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(ToshibaClimateUart),
+        cv.Optional(CONF_DURATION, default="10min"): cv.templatable(cv.positive_time_period_milliseconds),
+        cv.Optional(CONF_INTERVAL, default="1s"): cv.templatable(cv.positive_time_period_milliseconds),
+    }
+)
+
+CAPTURE_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(ToshibaClimateUart),
+    }
+)
+
+
+@automation.register_action("toshiba_suzumi.start_capture", StartCaptureAction, START_CAPTURE_SCHEMA)
+async def start_capture_to_code(config, action_id, template_arg, args):
+    cg.add_define("USE_TOSHIBA_SUZUMI_CAPTURE")
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    cg.add(var.set_duration(await cg.templatable(config[CONF_DURATION], args, cg.uint32)))
+    cg.add(var.set_interval(await cg.templatable(config[CONF_INTERVAL], args, cg.uint32)))
+    return var
+
+
+@automation.register_action("toshiba_suzumi.stop_capture", StopCaptureAction, CAPTURE_SCHEMA)
+async def stop_capture_to_code(config, action_id, template_arg, args):
+    cg.add_define("USE_TOSHIBA_SUZUMI_CAPTURE")
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+@automation.register_action("toshiba_suzumi.export_capture", ExportCaptureAction, CAPTURE_SCHEMA)
+async def export_capture_to_code(config, action_id, template_arg, args):
+    cg.add_define("USE_TOSHIBA_SUZUMI_CAPTURE")
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
@@ -0,0 +1,85 @@
+# PlatformIO post-build script, enabled by `size_report: true` in the climate configuration.
+# Prints flash and RAM used by the toshiba_suzumi component, split by optional feature.
+#
+# Features are attributed by symbol names. Decoders inlined into shared functions
+# (parseResponse, dump_config) are counted in "core" - compare reports of builds
+# with different configurations to see their full cost.
+import os
+import re
+import subprocess
+
+Import("env")  # noqa: F821 pylint: disable=undefined-variable
+
+NAMESPACE = "esphome::toshiba_suzumi::"
+DEFINE_PREFIX = "USE_TOSHIBA_SUZUMI_"
+
+# feature -> symbol name patterns
+FEATURES = {
+    "ENERGY": re.compile(r"energy|wattage", re.IGNORECASE),
+    "TIME_SYNC": re.compile(r"time_sync|sync_time"),
+    "PWR_SELECT": re.compile(r"PwrModeSelect|pwr_level|PwrLevel|PowerLevel"),
+    "VERTICAL_AIR_DIRECTION": re.compile(r"VerticalAirDirection|vertical_air_direction", re.IGNORECASE),
+    "SELF_CLEAN": re.compile(r"self_clean", re.IGNORECASE),
+    "CONNECTED": re.compile(r"connected_sensor"),
+    "LATENCY_REPORT": re.compile(r"latency_report"),
+    "LINK_STATS": re.compile(r"link_stats|LatencyHistogram"),
+    "REGISTER_TRIGGERS": re.compile(r"RegisterChangeTrigger|FrameTrigger|register_callback|frame_callback"),
+    "CAPTURE": re.compile(r"Capture|capture"),
+    "OUTDOOR_UNIT": re.compile(r"OutdoorUnit|outdoor_unit|outdoor_follower"),
+    "PROFILE": re.compile(r"Profiler|ProfileScope"),
+    "RX_TASK": re.compile(r"RxTask|SpscRing|rx_task"),
+    "RAW_REGISTER": re.compile(r"_register\b|RegisterAction|RegisterValueTrigger|register_value|raw_request"),
+}
+
+FLASH_TYPES = "tTrRwW"
+RAM_TYPES = "dDbBvV"
+
+
+def _enabled_features(env):
+    defines = os.path.join(env.subst("$PROJECT_SRC_DIR"), "esphome", "core", "defines.h")
+    if not os.path.isfile(defines):
+        return []
+    with open(defines, encoding="utf-8") as f:
+        return sorted(
+            m.group(1) for m in re.finditer(r"#define\s+" + DEFINE_PREFIX + r"(\w+)", f.read())
+        )
+
+
+def _symbols(nm, elf):
+    output = subprocess.run(
+        [nm, "--print-size", "--demangle", elf], capture_output=True, text=True, check=True
+    ).stdout
+    for line in output.splitlines():
+        parts = line.split(maxsplit=3)
+        if len(parts) != 4 or NAMESPACE not in parts[3]:
+            continue
+        yield parts[2], int(parts[1], 16), parts[3]
+
+
+def size_report(source, target, env):
+    elf = str(target[0])
+    nm = re.sub(r"gcc$", "nm", env.subst("$CC"))
+    sizes = {feature: [0, 0] for feature in [*FEATURES, "core"]}
+    try:
+        for sym_type, size, name in _symbols(nm, elf):
+            feature = next((f for f, pattern in FEATURES.items() if pattern.search(name)), "core")
+            if sym_type in FLASH_TYPES:
+                sizes[feature][0] += size
+            elif sym_type in RAM_TYPES:
+                sizes[feature][1] += size
+    except (OSError, subprocess.CalledProcessError) as err:
+        print(f"toshiba_suzumi size report failed: {err}")
+        return
+
+    print("toshiba_suzumi size report")
+    print(f"  enabled features: {', '.join(_enabled_features(env)) or 'none'}")
+    print(f"  {'feature':<24}{'flash':>10}{'RAM':>10}")
+    for feature, (flash, ram) in sizes.items():
+        if flash or ram:
+            print(f"  {feature:<24}{flash:>10}{ram:>10}")
+    total_flash = sum(flash for flash, _ in sizes.values())
+    total_ram = sum(ram for _, ram in sizes.values())
+    print(f"  {'total':<24}{total_flash:>10}{total_ram:>10}")
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", size_report)  # noqa: F821
@@ -0,0 +1,111 @@
+#include "toshiba_capabilities.h"
+#include "toshiba_climate.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+// registers which are not supported by all models, the others are always polled
+static const ToshibaCommandType OPTIONAL_REGISTERS[] = {
+    ToshibaCommandType::OUTDOOR_TEMP, ToshibaCommandType::SPECIAL_MODE, ToshibaCommandType::POWER_SEL,
+    ToshibaCommandType::SELF_CLEAN,   ToshibaCommandType::ENERGY_DAILY, ToshibaCommandType::COMFORT_SLEEP,
+};
+
+void ToshibaCapabilities::set_(uint32_t *bits, ToshibaCommandType reg, bool value) {
+  auto i = static_cast<uint8_t>(reg);
+  if (value) {
+    bits[i / 32] |= 1u << (i % 32);
+  } else {
+    bits[i / 32] &= ~(1u << (i % 32));
+  }
+}
+
+void ToshibaCapabilities::read_sent(ToshibaCommandType reg) {
+  if (this->pending_.has_value()) {
+    this->unanswered_ = this->pending_;
+  }
+  this->pending_ = reg;
+}
+
+bool ToshibaCapabilities::reply_received(ToshibaCommandType reg) {
+  bool changed = false;
+  if (this->pending_.has_value() && *this->pending_ == reg) {
+    if (this->unanswered_.has_value()) {
+      // the unit replies to the last read, but did not reply to the previous one
+      changed = this->missed_(*this->unanswered_);
+    }
+    this->pending_.reset();
+    this->unanswered_.reset();
+  } else if (this->unanswered_.has_value() && *this->unanswered_ == reg) {
+    // late reply
+    this->unanswered_.reset();
+  }
+
+  return this->mark_supported_(reg) || changed;
+}
+
+bool ToshibaCapabilities::frame_received(ToshibaCommandType reg) {
+  if (this->unanswered_.has_value() && *this->unanswered_ == reg) {
+    // late reply which came after the following read was already matched
+    this->unanswered_.reset();
+  }
+  return this->mark_supported_(reg);
+}
+
+bool ToshibaCapabilities::mark_supported_(ToshibaCommandType reg) {
+  for (auto &miss : this->misses_) {
+    if (miss.count != 0 && miss.reg == reg) {
+      miss.count = 0;
+    }
+  }
+  if (this->is_supported(reg) && !this->is_unsupported(reg)) {
+    return false;
+  }
+  ESP_LOGD(TAG, "Register %d is supported", static_cast<uint8_t>(reg));
+  set_(this->map_.supported, reg, true);
+  set_(this->map_.unsupported, reg, false);
+  return true;
+}
+
+bool ToshibaCapabilities::missed_(ToshibaCommandType reg) {
+  bool optional_register = false;
+  for (auto optional_reg : OPTIONAL_REGISTERS) {
+    optional_register |= optional_reg == reg;
+  }
+  if (!optional_register || this->is_unsupported(reg)) {
+    return false;
+  }
+  // find the counter of the register, or reuse the lowest one
+  Miss *slot = &this->misses_[0];
+  for (auto &miss : this->misses_) {
+    if (miss.count != 0 && miss.reg == reg) {
+      slot = &miss;
+      break;
+    }
+    if (miss.count < slot->count) {
+      slot = &miss;
+    }
+  }
+  if (slot->reg != reg || slot->count == 0) {
+    *slot = Miss{reg, 0};
+  }
+  if (++slot->count < MISSES_UNSUPPORTED) {
+    return false;
+  }
+  ESP_LOGI(TAG, "Register %d is not supported by the unit, it won't be polled", static_cast<uint8_t>(reg));
+  slot->count = 0;
+  set_(this->map_.unsupported, reg, true);
+  set_(this->map_.supported, reg, false);
+  return true;
+}
+
+void ToshibaCapabilities::reset() {
+  this->map_ = Map{};
+  this->pending_.reset();
+  this->unanswered_.reset();
+  for (auto &miss : this->misses_) {
+    miss.count = 0;
+  }
+}
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include "toshiba_climate_mode.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+/**
+ * Registers the unit answers, learned from replies to regular reads.
+ *
+ * Different models support different registers. A read of an optional register which stays
+ * unanswered while the unit replies to the following read counts as a miss, after
+ * MISSES_UNSUPPORTED misses the register is marked unsupported and is not polled anymore.
+ * Any later frame of the register (a late reply, or pushed by the unit) marks it supported again.
+ */
+class ToshibaCapabilities {
+ public:
+  static const uint8_t MISSES_UNSUPPORTED = 3;
+
+  /// Persisted state, one bit per register.
+  struct Map {
+    uint32_t supported[8];
+    uint32_t unsupported[8];
+  };
+
+  void read_sent(ToshibaCommandType reg);
+  /// A reply to a read was received. Returns true when the map changed.
+  bool reply_received(ToshibaCommandType reg);
+  /// A frame of the register was received without being read. Returns true when the map changed.
+  bool frame_received(ToshibaCommandType reg);
+
+  bool is_supported(ToshibaCommandType reg) const { return test_(this->map_.supported, reg); }
+  bool is_unsupported(ToshibaCommandType reg) const { return test_(this->map_.unsupported, reg); }
+
+  Map &map() { return this->map_; }
+  void reset();
+
+ protected:
+  static bool test_(const uint32_t *bits, ToshibaCommandType reg) {
+    auto i = static_cast<uint8_t>(reg);
+    return bits[i / 32] & (1u << (i % 32));
+  }
+  static void set_(uint32_t *bits, ToshibaCommandType reg, bool value);
+  bool missed_(ToshibaCommandType reg);
+  bool mark_supported_(ToshibaCommandType reg);
+
+  Map map_{};
+  // read sent last and not answered yet
+  optional<ToshibaCommandType> pending_;
+  // read sent before the pending one and not answered
+  optional<ToshibaCommandType> unanswered_;
+  struct Miss {
+    ToshibaCommandType reg;
+    uint8_t count;
+  };
+  Miss misses_[4]{};
+};
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
@@ -0,0 +1,151 @@
+#include "esphome/core/defines.h"
+#include "toshiba_capture.h"
+#ifdef USE_TOSHIBA_SUZUMI_CAPTURE
+#include <cinttypes>
+#include "toshiba_climate.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+// raw values reported by the unit when a value is not available
+static const uint8_t NO_TEMPERATURE = static_cast<uint8_t>(TEMP_UNKNOWN);
+static const uint8_t NO_VALUE = 255;
+
+void ToshibaCapture::start(uint32_t interval, uint32_t now) {
+  this->interval_ = interval;
+  this->started_at_ = now;
+  this->first_ = 0;
+  this->used_ = 0;
+  this->exporting_ = false;
+  this->running_ = true;
+  this->received_ = false;
+  const uint8_t unknown[CHANNELS] = {NO_TEMPERATURE, NO_TEMPERATURE, 0,        NO_TEMPERATURE,
+                                     NO_TEMPERATURE, NO_TEMPERATURE, NO_VALUE, NO_VALUE};
+  for (uint8_t i = 0; i < CHANNELS; i++) {
+    this->latest_[i] = unknown[i];
+  }
+}
+
+ToshibaCapture::Block &ToshibaCapture::new_block_(uint32_t now) {
+  if (this->used_ == BLOCKS) {
+    // window is full, drop the oldest block
+    this->first_ = (this->first_ + 1) % BLOCKS;
+    this->used_--;
+  }
+  auto &block = this->block_(this->used_++);
+  block.start = now;
+  block.count = 1;
+  block.slots_used = 0;
+  memset(block.raw, 0, sizeof(block.raw));
+  memcpy(block.key, this->latest_, CHANNELS);
+  return block;
+}
+
+void ToshibaCapture::sample(uint32_t now) {
+  if (!this->running_ || !this->received_) {
+    return;
+  }
+  int8_t deltas[CHANNELS];
+  bool fits = true;
+  for (uint8_t i = 0; i < CHANNELS && fits; i++) {
+    int delta = static_cast<int>(this->latest_[i]) - static_cast<int>(this->last_[i]);
+    fits = delta >= -8 && delta <= 7;
+    deltas[i] = delta;
+  }
+  uint8_t slots = fits ? 1 : 2;
+  Block *block = this->used_ == 0 ? nullptr : &this->block_(this->used_ - 1);
+  if (block == nullptr || block->count == BLOCK_SAMPLES || block->slots_used + slots > BLOCK_SLOTS) {
+    this->new_block_(now);
+  } else {
+    auto *slot = block->slots[block->slots_used];
+    if (fits) {
+      for (uint8_t i = 0; i < CHANNELS; i += 2) {
+        slot[i / 2] = (deltas[i] & 0x0F) | (deltas[i + 1] << 4);
+      }
+    } else {
+      // a single sample with raw values, the following deltas are based on it
+      memcpy(slot, this->latest_, CHANNELS);
+      block->raw[block->count / 8] |= 1 << (block->count % 8);
+    }
+    block->slots_used += slots;
+    block->count++;
+  }
+  memcpy(this->last_, this->latest_, CHANNELS);
+}
+
+uint16_t ToshibaCapture::size() const {
+  uint16_t count = 0;
+  for (uint8_t i = 0; i < this->used_; i++) {
+    count += this->blocks_[(this->first_ + i) % BLOCKS].count;
+  }
+  return count;
+}
+
+void ToshibaCapture::begin_export() {
+  this->exporting_ = true;
+  this->export_block_ = 0;
+  this->export_sample_ = 0;
+  this->export_slot_ = 0;
+  ESP_LOGI(TAG, "Capture CSV, %u samples:", this->size());
+  ESP_LOGI(TAG, "time_s,tc,tcj,fan_rpm,td,ts,te,load_pct,iac");
+}
+
+bool ToshibaCapture::export_lines(uint8_t max_lines) {
+  for (uint8_t line = 0; line < max_lines; line++) {
+    if (!this->exporting_ || this->export_block_ >= this->used_) {
+      this->exporting_ = false;
+      return false;
+    }
+    auto &block = this->block_(this->export_block_);
+    uint8_t sample = this->export_sample_;
+    if (sample == 0) {
+      memcpy(this->export_values_, block.key, CHANNELS);
+      this->export_slot_ = 0;
+    } else if (block.raw[sample / 8] & (1 << (sample % 8))) {
+      memcpy(this->export_values_, block.slots[this->export_slot_], CHANNELS);
+      this->export_slot_ += 2;
+    } else {
+      auto *packed = block.slots[this->export_slot_++];
+      for (uint8_t i = 0; i < CHANNELS; i++) {
+        uint8_t nibble = i % 2 == 0 ? packed[i / 2] & 0x0F : packed[i / 2] >> 4;
+        // sign-extend the 4-bit delta
+        int8_t delta = nibble & 0x08 ? static_cast<int8_t>(nibble | 0xF0) : static_cast<int8_t>(nibble);
+        this->export_values_[i] += delta;
+      }
+    }
+    this->log_sample_(block.start + this->export_sample_ * this->interval_ - this->started_at_, this->export_values_);
+    if (++this->export_sample_ == block.count) {
+      this->export_sample_ = 0;
+      this->export_block_++;
+    }
+  }
+  return true;
+}
+
+void ToshibaCapture::log_sample_(uint32_t time, const uint8_t *values) {
+  // invalid values are left empty
+  char temps[5][5];
+  const uint8_t temp_channels[5] = {TC, TCJ, TD, TS, TE};
+  for (uint8_t i = 0; i < 5; i++) {
+    uint8_t raw = values[temp_channels[i]];
+    if (raw == NO_TEMPERATURE) {
+      temps[i][0] = '\0';
+    } else {
+      snprintf(temps[i], sizeof(temps[i]), "%d", static_cast<int8_t>(raw));
+    }
+  }
+  char load[8] = "";
+  if (values[LOAD] < ODU_VALUE_UNKNOWN) {
+    snprintf(load, sizeof(load), "%.1f", values[LOAD] / 1.7f);
+  }
+  char iac[4] = "";
+  if (values[IAC] < ODU_VALUE_UNKNOWN) {
+    snprintf(iac, sizeof(iac), "%u", values[IAC]);
+  }
+  ESP_LOGI(TAG, "%" PRIu32 ".%03" PRIu32 ",%s,%s,%u,%s,%s,%s,%s,%s", time / 1000, time % 1000, temps[0], temps[1],
+           values[FAN_RPM], temps[2], temps[3], temps[4], load, iac);
+}
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
+#endif
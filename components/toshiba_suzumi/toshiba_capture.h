@@ -0,0 +1,84 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_TOSHIBA_SUZUMI_CAPTURE
+#include <cstdint>
+#include <cstring>
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+/**
+ * Commissioning capture of IDU/ODU telemetry into a fixed RAM ring.
+ *
+ * Samples are stored in blocks: a key sample with raw values followed by one 4-byte slot of
+ * 4-bit signed deltas per sample, instead of 8 bytes of raw values. A sample with a delta which
+ * doesn't fit (load, current or fan speed while the unit ramps) takes two slots with its raw values.
+ * The slots of a block suffice for BLOCK_SAMPLES samples with up to a fifth of them raw, so the ring
+ * holds BLOCKS * BLOCK_SAMPLES samples and never less than 60 % of them. When the ring is full,
+ * the oldest block is dropped.
+ */
+class ToshibaCapture {
+ public:
+  enum Channel : uint8_t { TC = 0, TCJ, FAN_RPM, TD, TS, TE, LOAD, IAC, CHANNELS };
+  static const uint8_t BLOCK_SAMPLES = 60;
+  // slots for the samples after the key sample, a raw sample takes two
+  static const uint8_t BLOCK_SLOTS = BLOCK_SAMPLES + BLOCK_SAMPLES / 5;
+  static const uint8_t BLOCKS = 11;
+
+  void start(uint32_t interval, uint32_t now);
+  void stop() { this->running_ = false; }
+  bool is_running() const { return this->running_; }
+  uint32_t started_at() const { return this->started_at_; }
+
+  /// Latest raw value of the channel from a decoded status frame.
+  void set(Channel channel, uint8_t raw) {
+    this->latest_[channel] = raw;
+    this->received_ = true;
+  }
+  /// Store the latest values as a sample taken at now.
+  void sample(uint32_t now);
+  uint16_t size() const;
+
+  /// Export the stored samples as CSV lines to the log, a few lines per call.
+  void begin_export();
+  /// Log up to max_lines lines. Returns false when the export is finished.
+  bool export_lines(uint8_t max_lines);
+
+ protected:
+  struct Block {
+    uint32_t start;  // millis of the key sample
+    uint8_t key[CHANNELS];
+    uint8_t count;  // samples in the block, the key sample included
+    uint8_t slots_used;
+    // bit N set: sample N is stored raw in two slots
+    uint8_t raw[(BLOCK_SAMPLES + 7) / 8];
+    uint8_t slots[BLOCK_SLOTS][CHANNELS / 2];
+  };
+  Block &block_(uint8_t index) { return this->blocks_[(this->first_ + index) % BLOCKS]; }
+  Block &new_block_(uint32_t now);
+  void log_sample_(uint32_t time, const uint8_t *values);
+
+  Block blocks_[BLOCKS];
+  uint8_t first_ = 0;
+  uint8_t used_ = 0;
+  uint32_t interval_ = 1000;
+  uint32_t started_at_ = 0;
+  bool running_ = false;
+  // a status frame was decoded since the start, samples before are not stored
+  bool received_ = false;
+  uint8_t latest_[CHANNELS]{};
+  // last stored sample, base of the next delta
+  uint8_t last_[CHANNELS]{};
+  // export cursor
+  bool exporting_ = false;
+  uint8_t export_block_ = 0;
+  uint8_t export_sample_ = 0;
+  uint8_t export_slot_ = 0;
+  uint8_t export_values_[CHANNELS]{};
+};
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
+#endif
@@ -1,7 +1,9 @@
+#include <cinttypes>
+#include <cstring>
 #include "toshiba_climate.h"
 #include "toshiba_climate_mode.h"
 #include "esphome/core/log.h"
-#ifdef USE_TIME
+#ifdef USE_TOSHIBA_SUZUMI_TIME_SYNC
 #include "esphome/components/time/real_time_clock.h"
 #endif
 
@@ -10,38 +12,215 @@ namespace toshiba_suzumi {
 
 using namespace esphome::climate;
 
-static const int RECEIVE_TIMEOUT = 200;
-static const int COMMAND_DELAY = 100;
+// settings re-read by the burst polling
+static const ToshibaCommandType BURST_REGISTERS[] = {ToshibaCommandType::POWER_STATE, ToshibaCommandType::MODE,
+                                                     ToshibaCommandType::TARGET_TEMP, ToshibaCommandType::FAN,
+                                                     ToshibaCommandType::SWING};
+
+uint8_t ToshibaPollScheduler::unit_count_ = 0;
 
 /**
- * Checksum is calculated from all bytes excluding start byte.
- * It's (256 - (sum % 256)).
+ * Format the frame as hex into the buffer, for logging without heap allocation.
+ * Frames which don't fit into the buffer are truncated.
  */
-uint8_t checksum(std::vector<uint8_t> data, uint8_t length) {
-  uint8_t sum = 0;
-  for (size_t i = 1; i < length; i++) {
-    sum += data[i];
+static const char *format_frame(char *buffer, size_t size, const uint8_t *data, size_t length) {
+  static const char *const HEX = "0123456789ABCDEF";
+  size_t pos = 0;
+  for (size_t i = 0; i < length && pos + 4 < size; i++) {
+    if (i > 0) {
+      buffer[pos++] = '.';
+    }
+    buffer[pos++] = HEX[data[i] >> 4];
+    buffer[pos++] = HEX[data[i] & 0x0F];
   }
-  return 256 - sum;
+  buffer[pos] = '\0';
+  return buffer;
 }
 
 ToshibaClimateUart::ToshibaClimateUart() {
-  this->last_time_sync_ = 0;
+#ifdef USE_TOSHIBA_SUZUMI_ENERGY
   this->last_energy_sync_ = 0;
   this->last_total_daily_energy_ = 0;
   this->last_energy_update_ms_ = 0;
-  for (int i = 0; i < 24; i++) {
-    this->daily_energy_usage_[i] = 0;
+#endif
+  this->unit_slot_ = ToshibaPollScheduler::register_unit();
+  this->control_state_.set_confirm_latency(&this->link_stats_.control_to_confirm);
+}
+
+/**
+ * Build the frame for the command taken from the line and send it to UART interface.
+ */
+void ToshibaClimateUart::send_to_uart(const ToshibaCommand &command) {
+  uint32_t now = this->line_.last_sent();
+  this->link_stats_.frames_sent++;
+  this->link_stats_.command_wait.record(now - command.enqueued_at);
+  this->awaiting_reply_ = true;
+  this->awaiting_reply_since_ = now;
+
+  uint8_t payload[TX_BUFFER_SIZE];
+  uint8_t length;
+  switch (command.action) {
+    case ToshibaCommandAction::FRAME:
+      this->write_frame_(command.frame->data, command.frame->length);
+      return;
+#ifdef USE_TOSHIBA_SUZUMI_TIME_SYNC
+    case ToshibaCommandAction::TIME_SYNC:
+      this->send_time_();
+      return;
+#endif
+    case ToshibaCommandAction::READ:
+      // unsupported registers found by scan may stay unanswered
+      if (this->scan_register_ == 0) {
+        this->unanswered_reads_++;
+        this->capabilities_.read_sent(command.cmd);
+      }
+      this->transactions_.read_sent(command.cmd, now);
+#ifdef USE_TOSHIBA_SUZUMI_RAW_REGISTER
+      if (this->has_raw_requests_()) {
+        this->raw_read_sent_(static_cast<uint8_t>(command.cmd), now);
+      }
+#endif
+      length = build_read_frame(payload, static_cast<uint8_t>(command.cmd));
+      break;
+    case ToshibaCommandAction::WRITE:
+      this->link_stats_.control_to_wire.record(now - command.enqueued_at);
+      this->control_state_.sent(command.cmd, now);
+      length = build_write_frame(payload, static_cast<uint8_t>(command.cmd), command.value);
+      break;
+    case ToshibaCommandAction::WRITE_PACKED:
+      this->send_packed_write_(command);
+      return;
+    default:
+      return;
+  }
+  this->write_frame_(payload, length);
+}
+
+void ToshibaClimateUart::write_frame_(const uint8_t *data, uint8_t length) {
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_VERBOSE
+  char buffer[3 * TX_BUFFER_SIZE];
+  ESP_LOGV(TAG, "Sending: [%s]", format_frame(buffer, sizeof(buffer), data, length));
+#endif
+  this->write_array(data, length);
+}
+
+void ToshibaClimateUart::save_capabilities_() {
+  ESP_LOGD(TAG, "Saving learned registers");
+  this->capabilities_dirty_ = false;
+  this->capabilities_pref_.save(&this->capabilities_.map());
+}
+
+void ToshibaClimateUart::reset_capabilities() {
+  ESP_LOGI(TAG, "Forgetting learned registers");
+  this->capabilities_.reset();
+  this->save_capabilities_();
+}
+
+void ToshibaClimateUart::connect_() {
+  // establish communication
+  this->start_handshake();
+  // load initial sensor data from the unit
+  this->getInitData();
+  // Set Wi-Fi LED initial state
+  this->set_wifi_led(!this->wifi_led_disabled_);
+}
+
+void ToshibaClimateUart::on_link_reply_() {
+  this->unanswered_reads_ = 0;
+  if (this->link_lost_) {
+    ESP_LOGI(TAG, "Communication with the unit restored");
+    this->link_lost_ = false;
+    this->reconnect_delay_ = RECONNECT_DELAY_MIN;
+  }
+#ifdef USE_TOSHIBA_SUZUMI_CONNECTED
+  if (this->connected_sensor_ != nullptr && !this->connected_sensor_->state) {
+    this->connected_sensor_->publish_state(true);
+  }
+#endif
+}
+
+/**
+ * The unit stopped replying (power cycle, UART glitch). Drop queued commands,
+ * they would be sent into silence, and repeat the handshake with exponential backoff.
+ */
+void ToshibaClimateUart::on_link_lost_() {
+  ESP_LOGW(TAG, "No reply from the unit to %u requests, reconnecting in %" PRIu32 "s", LINK_MISSED_REPLIES,
+           this->reconnect_delay_ / 1000);
+  this->link_lost_ = true;
+#ifdef USE_TOSHIBA_SUZUMI_CONNECTED
+  if (this->connected_sensor_ != nullptr) {
+    this->connected_sensor_->publish_state(false);
+  }
+#endif
+  // handlers of failed transactions may enqueue reads, they are dropped with the queue
+  this->transactions_.fail_all(this);
+  this->line_.reset();
+#ifdef USE_TOSHIBA_SUZUMI_RAW_REGISTER
+  // their reads were dropped with the queue
+  this->raw_read_count_ = 0;
+#endif
+  this->packed_write_ = ToshibaPackedWrite{};
+  // the unit may have been power cycled, settings are written again after reconnect,
+  // writes dropped with the queue are not waited for
+  this->control_state_.forget();
+  this->wifi_led_.reset();
+  this->poll_pending_ = false;
+  this->set_timeout("reconnect", this->reconnect_delay_, [this]() {
+    ESP_LOGI(TAG, "Reconnecting to the unit");
+    this->link_stats_.reconnects++;
+    this->connect_();
+  });
+  this->unanswered_reads_ = 0;
+  this->reconnect_delay_ *= 2;
+  if (this->reconnect_delay_ > RECONNECT_DELAY_MAX) {
+    this->reconnect_delay_ = RECONNECT_DELAY_MAX;
   }
 }
 
 /**
- * Send the command to UART interface.
+ * Start burst polling when a watched setting changes without being requested by us.
+ * The first report of each setting only initializes it.
  */
-void ToshibaClimateUart::send_to_uart(ToshibaCommand command) {
-  this->last_command_timestamp_ = millis();
-  ESP_LOGV(TAG, "Sending: [%s]", format_hex_pretty(command.payload).c_str());
-  this->write_array(command.payload);
+void ToshibaClimateUart::watch_register_(ToshibaCommandType reg, uint8_t value, bool requested) {
+  for (uint8_t i = 0; i < sizeof(BURST_REGISTERS) / sizeof(BURST_REGISTERS[0]); i++) {
+    if (BURST_REGISTERS[i] != reg) {
+      continue;
+    }
+    bool known = this->watched_known_ & (1 << i);
+    if (known && !requested && this->watched_values_[i] != value) {
+      this->start_burst_poll_("setting changed outside");
+    }
+    this->watched_values_[i] = value;
+    this->watched_known_ |= 1 << i;
+    return;
+  }
+}
+
+void ToshibaClimateUart::start_burst_poll_(const char *reason) {
+  bool running = this->burst_polls_left_ != 0;
+  // every detected change extends the burst
+  this->burst_polls_left_ = BURST_POLLS;
+  if (running) {
+    return;
+  }
+  ESP_LOGD(TAG, "Change detected (%s), polling settings every %" PRIu32 "ms", reason, BURST_POLL_INTERVAL);
+  this->burst_poll_();
+}
+
+void ToshibaClimateUart::burst_poll_() {
+  if (this->link_lost_) {
+    this->burst_polls_left_ = 0;
+    return;
+  }
+  this->burst_polls_left_--;
+  this->burst_polled_at_ = millis();
+  if (this->line_.queue_size() > COMMAND_QUEUE_SIZE / 2) {
+    // queue is busy, skip this round
+    return;
+  }
+  for (auto reg : BURST_REGISTERS) {
+    this->requestData(reg);
+  }
 }
 
 /**
@@ -49,120 +228,245 @@ void ToshibaClimateUart::send_to_uart(ToshibaCommand command) {
  */
 void ToshibaClimateUart::start_handshake() {
   ESP_LOGCONFIG(TAG, "Sending handshake...");
-  enqueue_command_(ToshibaCommand{.cmd = ToshibaCommandType::HANDSHAKE, .payload = HANDSHAKE[0]});
-  enqueue_command_(ToshibaCommand{.cmd = ToshibaCommandType::HANDSHAKE, .payload = HANDSHAKE[1]});
-  enqueue_command_(ToshibaCommand{.cmd = ToshibaCommandType::HANDSHAKE, .payload = HANDSHAKE[2]});
-  enqueue_command_(ToshibaCommand{.cmd = ToshibaCommandType::HANDSHAKE, .payload = HANDSHAKE[3]});
-  enqueue_command_(ToshibaCommand{.cmd = ToshibaCommandType::HANDSHAKE, .payload = HANDSHAKE[4]});
-  enqueue_command_(ToshibaCommand{.cmd = ToshibaCommandType::HANDSHAKE, .payload = HANDSHAKE[5]});
-  enqueue_command_(ToshibaCommand{.cmd = ToshibaCommandType::DELAY, .delay = 2000});
-  enqueue_command_(ToshibaCommand{.cmd = ToshibaCommandType::HANDSHAKE, .payload = AFTER_HANDSHAKE[0]});
-  enqueue_command_(ToshibaCommand{.cmd = ToshibaCommandType::HANDSHAKE, .payload = AFTER_HANDSHAKE[1]});
+  if (!this->line_.enqueue_handshake(millis())) {
+    ESP_LOGW(TAG, "Command queue is full, dropping handshake");
+    return;
+  }
+  this->commands_enqueued_();
 }
 
 /**
- * Handle data in RX buffer, validate message for content and checksum.
- * Since we know the format only of some messages (expected length), unknown messages
- * are ended via RECIEVE timeout.
+ * Log and count a frame completed by the framer, parse the valid one.
  */
-bool ToshibaClimateUart::validate_message_() {
-  uint8_t at = this->rx_message_.size() - 1;
-  auto *data = &this->rx_message_[0];
-  uint8_t new_byte = data[at];
+void ToshibaClimateUart::handle_frame_(ToshibaFramer::Status status) {
+  TOSHIBA_PROFILE(VALIDATE_MESSAGE);
+  auto *data = this->line_.framer().data();
+  uint8_t length = this->line_.framer().length();
+  char buffer[3 * RX_BUFFER_SIZE];
+
+  if (status == ToshibaFramer::CHECKSUM_ERROR) {
+    this->link_stats_.checksum_errors++;
+    ESP_LOGW(TAG, "Received invalid message checksum %02X!=%02X DATA=[%s]", data[length - 1],
+             checksum(data, length - 1), format_frame(buffer, sizeof(buffer), data, length));
+    return;
+  }
 
-  // Byte 0: HEADER (always 0x02)
-  if (at == 0)
-    return new_byte == 0x02;
+  // valid message
+  ESP_LOGV(TAG, "Received: DATA=[%s]", format_frame(buffer, sizeof(buffer), data, length));
+  this->link_stats_.frames_received++;
+  this->on_link_reply_();
+  if (this->awaiting_reply_) {
+    this->link_stats_.round_trip.record(millis() - this->awaiting_reply_since_);
+    this->awaiting_reply_ = false;
+  }
+  this->parseResponse(data, length);
+}
 
-  // always get first three bytes
-  if (at < 2) {
-    return true;
+bool ToshibaClimateUart::enqueue_command_(const ToshibaCommand &command) {
+  if (!this->line_.enqueue(command, millis())) {
+    ESP_LOGW(TAG, "Command queue is full, dropping command %d", static_cast<uint8_t>(command.cmd));
+    return false;
   }
+  this->commands_enqueued_();
+  return true;
+}
 
-  // Byte 3
-  if (data[2] != 0x03) {
-    // Normal commands starts with 0x02 0x00 0x03 and have length between 15-17 bytes.
-    // however there are some special unknown handshake commands which has non-standard replies.
-    // Since we don't know their format, we can't validate them.
-    return true;
+void ToshibaClimateUart::commands_enqueued_() {
+  if (this->line_.queue_size() > this->link_stats_.queue_high_watermark) {
+    this->link_stats_.queue_high_watermark = this->line_.queue_size();
   }
+  this->process_command_queue_();
+}
 
-  if (at <= 5) {
-    // no validation for these fields
-    return true;
+/**
+ * Write the value to the register. Writes of settings which the unit already holds are skipped
+ * (the unit beeps on each write), unless forced.
+ */
+void ToshibaClimateUart::sendCmd(ToshibaCommandType cmd, uint8_t value, bool force) {
+  if (!force && !this->force_writes_ && this->control_state_.holds(cmd, value)) {
+    ESP_LOGD(TAG, "Register %d already holds value %d, not writing it", static_cast<uint8_t>(cmd), value);
+    this->link_stats_.elided_writes++;
+    return;
   }
+  ESP_LOGD(TAG, "Sending ToshibaCommand: %d, value: %d", static_cast<uint8_t>(cmd), value);
+  this->control_state_.expect(cmd, value);
+  if (this->collecting_writes_) {
+    auto &packed = this->packed_write_;
+    for (uint8_t i = 0; i < packed.count; i++) {
+      if (packed.regs[i] == cmd) {
+        // written twice in one call (e.g. special mode by setpoint and preset), the last value wins
+        packed.values[i] = value;
+        return;
+      }
+    }
+    if (packed.count < PACKED_WRITE_MAX) {
+      packed.regs[packed.count] = cmd;
+      packed.values[packed.count] = value;
+      packed.count++;
+      return;
+    }
+  }
+  // expected before enqueuing, the command may be sent right away
+  if (!this->enqueue_command_(ToshibaCommand{.cmd = cmd, .action = ToshibaCommandAction::WRITE, .value = value})) {
+    this->control_state_.cancel(cmd);
+  }
+}
 
-  // Byte 7: LENGTH
-  uint8_t length = 6 + data[6] + 1;  // prefix + data + checksum
+/**
+ * Collect the following writes for one packed frame, until flush_writes_().
+ * Only when enabled, not rejected by the unit and no other packed write is in flight.
+ */
+void ToshibaClimateUart::begin_writes_() {
+  this->collecting_writes_ = this->packed_writes_ && !this->packed_writes_rejected_ && this->packed_write_.count == 0;
+}
+
+void ToshibaClimateUart::flush_writes_() {
+  this->collecting_writes_ = false;
+  auto &packed = this->packed_write_;
+  if (packed.count == 0 || packed.awaiting_ack) {
+    return;
+  }
+  if (packed.count == 1) {
+    packed.count = 0;
+    if (!this->enqueue_command_(ToshibaCommand{
+            .cmd = packed.regs[0], .action = ToshibaCommandAction::WRITE, .value = packed.values[0]})) {
+      this->control_state_.cancel(packed.regs[0]);
+    }
+    return;
+  }
+  ESP_LOGD(TAG, "Writing %u registers in one frame", packed.count);
+  if (!this->enqueue_command_(
+          ToshibaCommand{.cmd = packed.regs[0], .action = ToshibaCommandAction::WRITE_PACKED})) {
+    for (uint8_t i = 0; i < packed.count; i++) {
+      this->control_state_.cancel(packed.regs[i]);
+    }
+    packed = ToshibaPackedWrite{};
+  }
+}
 
-  // wait until all data is read
-  if (at < length)
-    return true;
+/**
+ * Send the collected writes in one frame, the unit confirms the whole frame with a single ACK.
+ */
+void ToshibaClimateUart::send_packed_write_(const ToshibaCommand &command) {
+  auto &packed = this->packed_write_;
+  uint32_t now = this->line_.last_sent();
+  uint8_t regs[PACKED_WRITE_MAX];
+  for (uint8_t i = 0; i < packed.count; i++) {
+    this->link_stats_.control_to_wire.record(now - command.enqueued_at);
+    regs[i] = static_cast<uint8_t>(packed.regs[i]);
+  }
+  uint8_t payload[TX_BUFFER_SIZE];
+  uint8_t length = build_packed_write_frame(payload, regs, packed.values, packed.count);
+  this->control_state_.sent_packed(packed.regs, packed.count, now);
+  packed.awaiting_ack = true;
+  packed.sent_at = now;
+  this->write_frame_(payload, length);
+}
 
-  // last byte: CHECKSUM
-  uint8_t rx_checksum = new_byte;
-  uint8_t calc_checksum = checksum(this->rx_message_, at);
+/**
+ * The unit didn't acknowledge the packed write, it likely doesn't support it.
+ * Write the registers one by one, now and from now on.
+ */
+void ToshibaClimateUart::on_packed_write_rejected_() {
+  ESP_LOGW(TAG, "Packed write was not acknowledged, writing registers one by one");
+  this->packed_writes_rejected_ = true;
+  auto &packed = this->packed_write_;
+  // the registers were sent once, when a repeated write is dropped the confirmation timeout re-reads them
+  for (uint8_t i = 0; i < packed.count; i++) {
+    this->enqueue_command_(
+        ToshibaCommand{.cmd = packed.regs[i], .action = ToshibaCommandAction::WRITE, .value = packed.values[i]});
+  }
+  packed = ToshibaPackedWrite{};
+}
 
-  if (rx_checksum != calc_checksum) {
-    ESP_LOGW(TAG, "Received invalid message checksum %02X!=%02X DATA=[%s]", rx_checksum, calc_checksum,
-             format_hex_pretty(data, length).c_str());
+bool ToshibaClimateUart::requestData(ToshibaCommandType cmd, bool force) {
+  if (!force && this->capabilities_.is_unsupported(cmd)) {
+    ESP_LOGV(TAG, "Skipping unsupported sensor %d", static_cast<uint8_t>(cmd));
     return false;
   }
+  ESP_LOGI(TAG, "Requesting data from sensor %d", static_cast<uint8_t>(cmd));
+  return this->enqueue_command_(ToshibaCommand{.cmd = cmd, .action = ToshibaCommandAction::READ});
+}
 
-  // valid message
-  ESP_LOGV(TAG, "Received: DATA=[%s]", format_hex_pretty(data, length).c_str());
-  this->parseResponse(this->rx_message_);
-
-  // return false to reset rx buffer
-  return false;
+bool ToshibaClimateUart::transact_(ToshibaCommandType reg, ToshibaReplyHandler on_reply,
+                                   ToshibaTimeoutHandler on_timeout) {
+  if (!this->transactions_.start(reg, on_reply, on_timeout, millis())) {
+    return false;
+  }
+  if (!this->requestData(reg)) {
+    // the reply won't come, don't wait for the timeout
+    this->transactions_.fail(this, reg);
+  }
+  return true;
 }
 
-void ToshibaClimateUart::enqueue_command_(const ToshibaCommand &command) {
-  this->command_queue_.push_back(command);
-  this->process_command_queue_();
+/**
+ * The unit reports ON while we believe it is off, e.g. powered on via IR remote, or the start
+ * of a post-shutdown self-clean cycle. When self-clean reporting is configured, query it first
+ * and read the mode only when no cycle is running (the entity stays OFF during the cycle).
+ */
+void ToshibaClimateUart::check_self_clean_then_mode_() {
+#ifdef USE_TOSHIBA_SUZUMI_SELF_CLEAN
+  if (this->self_clean_sensor_ != nullptr) {
+    if (this->transactions_.is_running(ToshibaCommandType::SELF_CLEAN) ||
+        this->transact_(ToshibaCommandType::SELF_CLEAN, &ToshibaClimateUart::on_self_clean_checked_,
+                        &ToshibaClimateUart::on_mode_reread_needed_)) {
+      return;
+    }
+  }
+#endif
+  this->on_mode_reread_needed_();
 }
 
-void ToshibaClimateUart::sendCmd(ToshibaCommandType cmd, uint8_t value) {
-  std::vector<uint8_t> payload = {2, 0, 3, 16, 0, 0, 7, 1, 48, 1, 0, 2};
-  payload.push_back(static_cast<uint8_t>(cmd));
-  payload.push_back(value);
-  payload.push_back(checksum(payload, payload.size()));
-  ESP_LOGD(TAG, "Sending ToshibaCommand: %d, value: %d, checksum: %d", cmd, value, payload[14]);
-  this->enqueue_command_(ToshibaCommand{.cmd = cmd, .payload = std::vector<uint8_t>{payload}});
+void ToshibaClimateUart::on_mode_reread_needed_() { this->requestData(ToshibaCommandType::MODE); }
+
+#ifdef USE_TOSHIBA_SUZUMI_SELF_CLEAN
+void ToshibaClimateUart::on_self_clean_checked_(uint8_t /*value*/) {
+  if (!this->self_clean_running_) {
+    this->on_mode_reread_needed_();
+  }
 }
 
-void ToshibaClimateUart::requestData(ToshibaCommandType cmd) {
-  std::vector<uint8_t> payload = {2, 0, 3, 16, 0, 0, 6, 1, 48, 1, 0, 1};
-  payload.push_back(static_cast<uint8_t>(cmd));
-  payload.push_back(checksum(payload, payload.size()));
-  ESP_LOGI(TAG, "Requesting data from sensor %d, checksum: %d", payload[12], payload[13]);
-  this->enqueue_command_(ToshibaCommand{.cmd = cmd, .payload = std::vector<uint8_t>{payload}});
+void ToshibaClimateUart::on_self_clean_ended_(uint8_t power_state) {
+  // the cycle was interrupted by switching the unit back on
+  if (static_cast<STATE>(power_state) == STATE::ON) {
+    this->on_mode_reread_needed_();
+  }
 }
+#endif
 
 void ToshibaClimateUart::getInitData() {
   ESP_LOGD(TAG, "Requesting initial data from AC unit");
   this->requestData(ToshibaCommandType::POWER_STATE);
+#ifdef USE_TOSHIBA_SUZUMI_SELF_CLEAN
   if (this->self_clean_sensor_ != nullptr) {
     this->requestData(ToshibaCommandType::SELF_CLEAN);
   }
+#endif
   this->requestData(ToshibaCommandType::MODE);
   this->requestData(ToshibaCommandType::TARGET_TEMP);
   this->requestData(ToshibaCommandType::FAN);
   this->requestData(ToshibaCommandType::POWER_SEL);
   this->requestData(ToshibaCommandType::SWING);
   this->requestData(ToshibaCommandType::ROOM_TEMP);
-  this->requestData(ToshibaCommandType::OUTDOOR_TEMP);
+  if (!this->is_outdoor_follower_()) {
+    this->requestData(ToshibaCommandType::OUTDOOR_TEMP);
+  }
   this->requestData(ToshibaCommandType::SPECIAL_MODE);
-  if (this->energy_sensor_ != nullptr || this->power_sensor_ != nullptr) {
+#ifdef USE_TOSHIBA_SUZUMI_ENERGY
+  if (this->has_energy_sensors_()) {
     this->requestData(ToshibaCommandType::ENERGY_DAILY);
   }
+#endif
 }
 
 void ToshibaClimateUart::set_self_clean_running_(bool running) {
   this->self_clean_running_ = running;
+#ifdef USE_TOSHIBA_SUZUMI_SELF_CLEAN
   if (this->self_clean_sensor_ != nullptr) {
     this->self_clean_sensor_->publish_state(running);
   }
+#endif
 }
 
 /**
@@ -175,61 +479,172 @@ void ToshibaClimateUart::configure_supported_custom_modes_() {
   this->set_supported_custom_fan_modes({CUSTOM_FAN_LEVEL_2, CUSTOM_FAN_LEVEL_4});
 
   // go over all defined presets and filter out the ones that are supported by the climate component
-  if (!this->supported_presets_.empty()) {
-    std::vector<const char *> custom_preset_names;
-    for (const char *preset_string : this->supported_presets_) {
-      if (!StringToClimatePreset(preset_string).has_value()) {
-        // preset is not supported by the climate component, add it to the custom presets
-        custom_preset_names.push_back(preset_string);
-      }
+  std::vector<const char *> custom_preset_names;
+  for (size_t i = 0; i < SPECIAL_MODE_TABLE.size(); i++) {
+    auto const &mode = SPECIAL_MODE_TABLE[i];
+    if (this->is_special_mode_supported_(mode.value) && !SpecialModeToClimatePreset(mode.value).has_value()) {
+      // preset is not supported by the climate component, add it to the custom presets
+      custom_preset_names.push_back(mode.name);
     }
-    // if there are any custom presets, set them for the climate component
-    if (!custom_preset_names.empty()) {
-      this->set_supported_custom_presets(custom_preset_names);
+  }
+  // if there are any custom presets, set them for the climate component
+  if (!custom_preset_names.empty()) {
+    this->set_supported_custom_presets(custom_preset_names);
+  }
+}
+
+void ToshibaClimateUart::set_supported_presets(const std::vector<const char *> &presets) {
+  this->supported_special_modes_ = 0;
+  for (const char *preset : presets) {
+    auto mode = PresetToSpecialMode(preset);
+    if (mode.has_value()) {
+      this->supported_special_modes_ |= 1 << SPECIAL_MODE_TABLE.index_of(*mode);
     }
   }
+  this->traits_built_ = false;
 }
 
 void ToshibaClimateUart::setup() {
   this->configure_supported_custom_modes_();
-  // establish communication
-  this->start_handshake();
-  // load initial sensor data from the unit
-  this->getInitData();
-  // Set Wi-Fi LED initial state
-  this->set_wifi_led(!this->wifi_led_disabled_);
+  this->capabilities_pref_ = global_preferences->make_preference<ToshibaCapabilities::Map>(
+      this->get_object_id_hash() ^ fnv1_hash("toshiba_suzumi_capabilities"), true);
+  if (!this->capabilities_pref_.load(&this->capabilities_.map())) {
+    this->capabilities_.reset();
+  }
+  // with more units on one node, don't let all of them handshake and load data in the same loop
+  this->set_timeout("setup", UNIT_SETUP_STAGGER * this->unit_slot_, [this]() { this->connect_(); });
+#ifdef USE_TOSHIBA_SUZUMI_ENERGY
+  this->set_interval("energy", ENERGY_SYNC_CHECK, [this]() { this->check_energy_sync_(); });
+  if (this->lifetime_energy_sensor_ != nullptr) {
+    this->energy_pref_ = global_preferences->make_preference<ToshibaEnergyState>(
+        this->get_object_id_hash() ^ fnv1_hash("toshiba_suzumi_energy"), true);
+    if (this->energy_pref_.load(&this->energy_state_)) {
+      // hours of the saved day allow counting consumption while the node was offline
+      this->energy_baseline_ = true;
+      ESP_LOGD(TAG, "Restored lifetime energy: %" PRIu32 " Wh", this->energy_state_.lifetime);
+      this->lifetime_energy_sensor_->publish_state(this->energy_state_.lifetime);
+    } else {
+      this->energy_state_ = ToshibaEnergyState{};
+    }
+  }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_RX_TASK
+  if (this->use_rx_task_) {
+    this->rx_task_.start(this);
+  }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_PROFILE
+  this->set_interval("profile", this->profile_interval_, [this]() {
+    this->profiler_.log("Profile of the last period");
+    this->profiler_.reset();
+  });
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_LINK_STATS
+  if (this->has_link_stats_sensors_()) {
+    this->set_interval("link_stats", this->link_stats_interval_, [this]() { this->publish_link_stats_(); });
+  }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_LATENCY_REPORT
+  // with link stats sensors the report is logged by each publish, both cover the same period
+  if (this->latency_report_interval_ != 0 && !this->has_link_stats_sensors_()) {
+    this->set_interval("latency_report", this->latency_report_interval_, [this]() {
+      this->log_latency_report_();
+      this->reset_latency_stats_();
+    });
+  }
+#endif
 }
 
 /**
- * Detect RX timeout and send next command in the queue to the unit.
+ * Run the queue and schedule its next run. loop() runs it again only when data was received
+ * or the scheduled time has come, enqueued commands run it right away.
  */
 void ToshibaClimateUart::process_command_queue_() {
+  TOSHIBA_PROFILE(PROCESS_COMMAND_QUEUE);
+  this->run_command_queue_();
+  uint32_t now = millis();
+  this->queue_wakeup_at_ = now + this->queue_idle_time_(now);
+}
+
+/**
+ * Time until run_command_queue_() has something to do: receive timeout, link supervision,
+ * reply and confirmation timeouts, next send or expiry of a DELAY.
+ */
+uint32_t ToshibaClimateUart::queue_idle_time_(uint32_t now) {
+  uint32_t wait = QUEUE_MAX_IDLE;
+  if (this->unanswered_reads_ >= LINK_MISSED_REPLIES) {
+    wait_until(wait, now, this->line_.last_sent() + LINK_REPLY_TIMEOUT + 1);
+  }
+  optional<uint32_t> deadline;
+  if ((deadline = this->transactions_.next_deadline()).has_value()) {
+    wait_until(wait, now, *deadline);
+  }
+  if (this->packed_write_.awaiting_ack) {
+    wait_until(wait, now, this->packed_write_.sent_at + PACKED_WRITE_ACK_TIMEOUT + 1);
+  }
+#ifdef USE_TOSHIBA_SUZUMI_RAW_REGISTER
+  if ((deadline = this->next_raw_read_deadline_()).has_value()) {
+    wait_until(wait, now, *deadline);
+  }
+#endif
+  if ((deadline = this->control_state_.next_deadline()).has_value()) {
+    wait_until(wait, now, *deadline);
+  }
+  if (this->scan_register_ != 0 && this->line_.queue_size() < 2) {
+    wait = 0;
+  }
+  return this->line_.idle_time(now, wait);
+}
+
+/**
+ * Detect RX timeout and send next command in the queue to the unit.
+ */
+void ToshibaClimateUart::run_command_queue_() {
   uint32_t now = millis();
 
-  uint32_t cmdDelay = now - this->last_command_timestamp_;
+  uint32_t cmdDelay = now - this->line_.last_sent();
 
-  // when we have not processed message and timeout since last received byte has expired,
-  // we likely won't receive any more data and there is nothing we can do with the message as it's
-  // format is was not recognized by validate_message_ function.
-  // Nothing to do - drop the message to free up communication and allow to send next command.
-  if (now - this->last_rx_char_timestamp_ > RECEIVE_TIMEOUT) {
-    this->rx_message_.clear();
+  // the format of the partially received message was not recognized and no more data came,
+  // drop it to free up communication and allow to send next command
+  if (this->line_.expire_partial_frame(now)) {
+    this->link_stats_.rx_timeouts++;
   }
 
-  // when there is no RX message and there is a command to send
-  if (cmdDelay > COMMAND_DELAY && !this->command_queue_.empty() && this->rx_message_.empty()) {
-    auto newCommand = this->command_queue_.front();
-    if (newCommand.cmd == ToshibaCommandType::DELAY && cmdDelay < newCommand.delay) {
-      // delay command did not finished yet
-      return;
-    }
-    // DELAY commands don't send data over UART, just remove them from queue
-    if (newCommand.cmd == ToshibaCommandType::DELAY) {
-      this->command_queue_.erase(this->command_queue_.begin());
-      return;
+  // the unit doesn't reply to reads, the last one had enough time
+  if (this->unanswered_reads_ >= LINK_MISSED_REPLIES && cmdDelay > LINK_REPLY_TIMEOUT) {
+    this->on_link_lost_();
+    return;
+  }
+
+  this->transactions_.check_timeouts(this, now);
+#ifdef USE_TOSHIBA_SUZUMI_RAW_REGISTER
+  if (this->has_raw_requests_()) {
+    this->expire_raw_requests_(now);
+  }
+#endif
+
+  if (this->packed_write_.awaiting_ack && now - this->packed_write_.sent_at > PACKED_WRITE_ACK_TIMEOUT) {
+    this->on_packed_write_rejected_();
+  }
+
+  // re-read settings which the unit did not confirm in time
+  optional<ToshibaCommandType> reread;
+  while ((reread = this->control_state_.check_timeouts(now)).has_value()) {
+    this->requestData(*reread);
+  }
+
+  // scan enqueues registers gradually to not flood the queue
+  if (this->scan_register_ != 0 && this->line_.queue_size() < 2) {
+    this->requestData(static_cast<ToshibaCommandType>(this->scan_register_), true);
+    if (++this->scan_register_ == 255) {
+      this->scan_register_ = 0;
     }
-    this->send_to_uart(this->command_queue_.front());
-    this->command_queue_.erase(this->command_queue_.begin());
+  }
+
+  // when the line is idle (no RX message, no reply expected) and there is a command to send
+  ToshibaCommand command;
+  if (!this->transactions_.awaiting_reply(now) && this->line_.take(now, &command)) {
+    this->send_to_uart(command);
   }
 }
 
@@ -237,91 +652,191 @@ void ToshibaClimateUart::process_command_queue_() {
  * Handle received byte from UART
  */
 void ToshibaClimateUart::handle_rx_byte_(uint8_t c) {
-  this->rx_message_.push_back(c);
-  if (!validate_message_()) {
-    this->rx_message_.clear();
-  } else {
-    this->last_rx_char_timestamp_ = millis();
+  TOSHIBA_PROFILE(HANDLE_RX_BYTE);
+  auto status = this->line_.feed(c, millis());
+  if (status == ToshibaFramer::OVERFLOW) {
+    ESP_LOGW(TAG, "Received message is too long, dropping it");
+    this->link_stats_.unknown_frames++;
+  } else if (status == ToshibaFramer::FRAME || status == ToshibaFramer::CHECKSUM_ERROR) {
+    this->handle_frame_(status);
   }
 }
 
-void ToshibaClimateUart::loop() {
-  while (available()) {
-    uint8_t c;
-    this->read_byte(&c);
-    this->handle_rx_byte_(c);
+/**
+ * Read the next chunk of received data, from the RX task's ring when it runs, otherwise from UART.
+ * Returns the number of bytes read, 0 when there is nothing to read.
+ */
+size_t ToshibaClimateUart::read_rx_chunk_(uint8_t *chunk) {
+#ifdef USE_TOSHIBA_SUZUMI_RX_TASK
+  if (this->rx_task_.is_running()) {
+    return this->rx_task_.read(chunk, RX_CHUNK_SIZE);
   }
-  this->process_command_queue_();
+#endif
+  int available = this->available();
+  if (available <= 0) {
+    return 0;
+  }
+  size_t length = available < RX_CHUNK_SIZE ? available : RX_CHUNK_SIZE;
+  return this->read_array(chunk, length) ? length : 0;
 }
 
-void ToshibaClimateUart::parseResponse(std::vector<uint8_t> rawData) {
-  uint8_t length = rawData.size();
-  ToshibaCommandType sensor;
-  uint8_t value;
+bool ToshibaClimateUart::rx_pending_() {
+#ifdef USE_TOSHIBA_SUZUMI_RX_TASK
+  if (this->rx_task_.is_running()) {
+    return this->rx_task_.available() > 0;
+  }
+#endif
+  return this->available() > 0;
+}
 
-  switch (length) {
-    case 15:  // response to requestData with the actual value of sensor/setting
-      sensor = static_cast<ToshibaCommandType>(rawData[12]);
-      value = rawData[13];
+/**
+ * Read received data in chunks and process it within the time budget. Data which
+ * don't fit into the budget stay in the UART buffer and are processed in the next loop.
+ */
+void ToshibaClimateUart::loop() {
+  TOSHIBA_PROFILE(LOOP);
+  uint32_t start = micros();
+  uint8_t chunk[RX_CHUNK_SIZE];
+  bool pending = false;
+  bool received = false;
+  size_t length;
+#ifdef USE_TOSHIBA_SUZUMI_RX_TASK
+  if (this->rx_task_.overflows() != this->rx_overflows_) {
+    ESP_LOGW(TAG, "RX ring overflow, %u bytes dropped", this->rx_task_.overflows() - this->rx_overflows_);
+    this->rx_overflows_ = this->rx_task_.overflows();
+  }
+#endif
+  while ((length = this->read_rx_chunk_(chunk)) > 0) {
+    received = true;
+    for (size_t i = 0; i < length; i++) {
+      this->handle_rx_byte_(chunk[i]);
+    }
+    if (micros() - start > this->loop_budget_us_) {
+      pending = this->rx_pending_();
+      if (pending) {
+        this->link_stats_.loop_budget_exceeded++;
+      }
       break;
-    case 16:  // probably ACK for issued command
-      // Check if this is a SET_DATE_TIME ACK (ends in 0x99 0x99)
-      if (rawData[14] == 0x99) {
-          ESP_LOGD(TAG, "AC unit acknowledged time synchronization.");
-          this->time_synced_ = true;
+    }
+  }
+  this->run_deadlines_(millis());
+  // don't send next command while the reply may still be waiting in the UART buffer,
+  // otherwise the queue has nothing to do until data arrives or its next deadline
+  if (!pending && (received || (int32_t) (millis() - this->queue_wakeup_at_) >= 0)) {
+    this->process_command_queue_();
+  }
+  uint32_t duration = micros() - start;
+  if (duration > this->link_stats_.peak_loop_time) {
+    this->link_stats_.peak_loop_time = duration;
+  }
+}
+
+void ToshibaClimateUart::parseResponse(const uint8_t *rawData, uint8_t length) {
+  TOSHIBA_PROFILE(PARSE_RESPONSE);
+  auto decoded = decode_reply(rawData, length);
+  switch (decoded.kind) {
+    case ToshibaReplyKind::TIME_SYNC_ACK:
+#ifdef USE_TOSHIBA_SUZUMI_TIME_SYNC
+      ESP_LOGD(TAG, "AC unit acknowledged time synchronization.");
+      this->time_synced_ = true;
+      return;
+#endif
+      // without time sync it's an ordinary ACK
+      // fall through
+    case ToshibaReplyKind::ACK:
+      ESP_LOGD(TAG, "Received message with length: %d", length);
+      if (this->packed_write_.awaiting_ack) {
+        ESP_LOGV(TAG, "Packed write acknowledged");
+        this->packed_write_ = ToshibaPackedWrite{};
       }
-      ESP_LOGD(TAG, "Received message with length: %d and value %s", length, format_hex_pretty(rawData).c_str());
+      this->control_state_.acknowledged();
       return;
-    case 17:  // response to requestData with the actual value of sensor/setting
-      sensor = static_cast<ToshibaCommandType>(rawData[14]);
-      value = rawData[15];
-      break;
-    case 69:
-    case 70:  // energy daily response
-      sensor = static_cast<ToshibaCommandType>(rawData[14]);
-      value = 0;
-      break;
-    case 22:  // extended status message (e.g., ODU_STATUS / IDU_STATUS)
-      sensor = static_cast<ToshibaCommandType>(rawData[12]);
-      value = 0;
-      break;
-    case 24:  // extended status message (e.g., ODU_STATUS / IDU_STATUS)
-      sensor = static_cast<ToshibaCommandType>(rawData[14]);
-      value = 0;
-      break;
-    default:
+    case ToshibaReplyKind::UNKNOWN: {
+      this->link_stats_.unknown_frames++;
+      char buffer[3 * RX_BUFFER_SIZE];
       ESP_LOGW(TAG, "Received unknown message with length: %d and value %s", length,
-               format_hex_pretty(rawData).c_str());
+               format_frame(buffer, sizeof(buffer), rawData, length));
       return;
+    }
+    default:
+      break;
+  }
+  auto sensor = static_cast<ToshibaCommandType>(decoded.reg);
+  uint8_t value = decoded.value;
+  // value and status frames reply to reads, unless the unit pushes them on its own
+  // (e.g. change by IR remote, IDU status)
+  bool reply = this->transactions_.frame_received(sensor);
+  if (!reply) {
+    this->link_stats_.unsolicited_frames++;
+    ESP_LOGV(TAG, "Unsolicited frame of sensor %d", static_cast<uint8_t>(sensor));
+  }
+  if (reply ? this->capabilities_.reply_received(sensor) : this->capabilities_.frame_received(sensor)) {
+    // learned registers change rarely, save them together
+    this->capabilities_dirty_ = true;
+    this->capabilities_changed_at_ = millis();
+  }
+#ifdef USE_TOSHIBA_SUZUMI_RAW_REGISTER
+  if (decoded.kind == ToshibaReplyKind::VALUE && this->take_raw_request_(static_cast<uint8_t>(sensor))) {
+    ESP_LOGI(TAG, "Register %d has value %d", static_cast<uint8_t>(sensor), value);
+    this->register_value_callback_.call(static_cast<uint8_t>(sensor), value);
+  }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_REGISTER_TRIGGERS
+  this->frame_callback_.call(static_cast<uint8_t>(sensor), rawData, length);
+#endif
+  // value of a setting written by us, not a change made outside: still awaiting the confirmation,
+  // or already confirmed by the ACK of our write
+  bool requested = this->control_state_.expected(sensor).has_value() || this->control_state_.holds(sensor, value);
+  if (!this->control_state_.reported(sensor, value)) {
+    // older value polled before the unit applied the requested one
+    return;
+  }
+  if (decoded.kind == ToshibaReplyKind::VALUE) {
+    this->watch_register_(sensor, value, requested);
+  }
+  // the capture samples the status frames, their sensors aren't published meanwhile
+  [[maybe_unused]] bool publish_status = true;
+#ifdef USE_TOSHIBA_SUZUMI_CAPTURE
+  if (this->capture_.is_running() &&
+      (sensor == ToshibaCommandType::IDU_STATUS || sensor == ToshibaCommandType::ODU_STATUS)) {
+    this->capture_status_(sensor, rawData + decoded.data_offset);
+    publish_status = false;
   }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_REGISTER_TRIGGERS
+  if (decoded.kind == ToshibaReplyKind::VALUE) {
+    this->register_callback_.call(static_cast<uint8_t>(sensor), value);
+  }
+#endif
   switch (sensor) {
     case ToshibaCommandType::ENERGY_DAILY: {
+#ifdef USE_TOSHIBA_SUZUMI_ENERGY
       ESP_LOGI(TAG, "Received daily energy update");
-      uint32_t total_energy = 0;
-#ifdef USE_TIME
-      uint8_t current_hour = (this->time_ != nullptr) ? this->time_->now().hour : 25;
-#else
-      uint8_t current_hour = 25;
-#endif
-      for (uint8_t i = 0; i < 24; i++) {
-        uint16_t hour_val = (rawData[21 + (i * 2) + 1] << 8) | rawData[21 + (i * 2)];
-        this->daily_energy_usage_[i] = hour_val;
-        total_energy += hour_val;
-        if (i == current_hour) {
-            ESP_LOGD(TAG, "  Current hour (%d) consumption: %u Wh", i, hour_val);
+      uint16_t hours[24];
+      uint32_t total_energy = decode_energy_daily(rawData, hours);
+#ifdef USE_TOSHIBA_SUZUMI_TIME_SYNC
+      if (this->time_ != nullptr) {
+        uint8_t current_hour = this->time_->now().hour;
+        if (current_hour < 24) {
+          ESP_LOGD(TAG, "  Current hour (%d) consumption: %u Wh", current_hour, hours[current_hour]);
         }
       }
+#endif
       if (this->energy_sensor_ != nullptr) {
         this->energy_sensor_->publish_state(total_energy);
       }
       this->estimate_wattage_(total_energy);
+      if (this->lifetime_energy_sensor_ != nullptr) {
+        this->update_lifetime_energy_(hours);
+      }
+#endif
       break;
     }
     case ToshibaCommandType::TARGET_TEMP:
       ESP_LOGI(TAG, "Received target temp: %d", value);
       if (this->special_mode_ == SPECIAL_MODE::EIGHT_DEG) {
-        // if special mode is EIGHT_DEG, shift the target temperature by SPECIAL_TEMP_OFFSET
-        value -= SPECIAL_TEMP_OFFSET;
+        // if special mode is EIGHT_DEG, the target temperature is shifted by SPECIAL_TEMP_OFFSET
+        value = decode_target_temp(value, true);
 
         ESP_LOGI(TAG, "Note: Special Mode \"%s\" is active, shifting target temp to %d", SPECIAL_MODE_EIGHT_DEG, value);
       }
@@ -352,82 +867,89 @@ void ToshibaClimateUart::parseResponse(std::vector<uint8_t> rawData) {
     }
     case ToshibaCommandType::SWING: {
       auto swing = static_cast<SWING>(value);
+#ifdef USE_TOSHIBA_SUZUMI_VERTICAL_AIR_DIRECTION
       auto air_direction = SwingToVerticalAirDirection(swing);
       if (air_direction != nullptr) {
         ESP_LOGI(TAG, "Received vertical air direction: %s", air_direction);
         this->publish_vertical_air_direction_(swing);
       }
+#endif
 
       if (IsFixedVerticalAirDirection(swing)) {
         this->swing_mode = climate::CLIMATE_SWING_OFF;
       } else {
         auto swingMode = IntToClimateSwingMode(swing);
-        ESP_LOGI(TAG, "Received swing mode: %s", climate_swing_mode_to_string(swingMode));
+        ESP_LOGI(TAG, "Received swing mode: %s", LOG_STR_ARG(climate_swing_mode_to_string(swingMode)));
         this->swing_mode = swingMode;
       }
       break;
     }
     case ToshibaCommandType::MODE: {
       auto mode = IntToClimateMode(static_cast<MODE>(value));
-      ESP_LOGI(TAG, "Received AC mode: %s", climate_mode_to_string(mode));
+      ESP_LOGI(TAG, "Received AC mode: %s", LOG_STR_ARG(climate_mode_to_string(mode)));
       if (this->power_state_ == STATE::ON && !this->self_clean_running_) {
         this->mode = mode;
       }
       break;
     }
     case ToshibaCommandType::ROOM_TEMP:
-      if (value != 127) {
+      if ((int8_t) value != TEMP_UNKNOWN) {
         ESP_LOGI(TAG, "Received room temp: %d °C", value);
         this->current_temperature = value;
+#ifdef USE_TOSHIBA_SUZUMI_INDOOR_TEMP
         if (indoor_temp_sensor_ != nullptr) {
           indoor_temp_sensor_->publish_state((int8_t) value);
         }
+#endif
       }
       break;
     case ToshibaCommandType::OUTDOOR_TEMP:
-      if (value != 127) {
-        if (outdoor_temp_sensor_ != nullptr) {
-          ESP_LOGI(TAG, "Received outdoor temp: %d °C", (int8_t) value);
-          outdoor_temp_sensor_->publish_state((int8_t) value);
-        }
+      if ((int8_t) value == TEMP_UNKNOWN) {
+        break;
+      }
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT
+      if (this->outdoor_unit_ != nullptr) {
+        this->outdoor_unit_->outdoor_temp_received(this, (int8_t) value);
+        break;
       }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_TEMP
+      this->publish_outdoor_temp_((int8_t) value);
+#endif
       break;
     case ToshibaCommandType::POWER_SEL: {
-      auto pwr_level = IntToPowerLevel(static_cast<PWR_LEVEL>(value));
       ESP_LOGI(TAG, "Received power select: %d", value);
+#ifdef USE_TOSHIBA_SUZUMI_PWR_SELECT
       if (pwr_select_ != nullptr) {
-        pwr_select_->publish_state(pwr_level);
+        pwr_select_->publish_state(IntToPowerLevel(static_cast<PWR_LEVEL>(value)));
       }
+#endif
       break;
     }
     case ToshibaCommandType::POWER_STATE: {
       auto climateState = static_cast<STATE>(value);
-      ESP_LOGI(TAG, "Received AC unit power state: %s", climate_state_to_string(climateState));
+      ESP_LOGI(TAG, "Received AC unit power state: %s", LOG_STR_ARG(climate_state_to_string(climateState)));
       if (climateState == STATE::OFF) {
         // AC unit was just powered off, set mode to OFF
         this->mode = climate::CLIMATE_MODE_OFF;
         this->set_self_clean_running_(false);
       } else if (this->self_clean_running_) {
+#ifdef USE_TOSHIBA_SUZUMI_SELF_CLEAN
         if (this->self_clean_sensor_ != nullptr) {
           ESP_LOGD(TAG, "Refreshing self-clean status after receiving AC ON state");
           this->requestData(ToshibaCommandType::SELF_CLEAN);
         }
-      } else if (this->mode == climate::CLIMATE_MODE_OFF && climateState == STATE::ON) {
-        // Unit reports ON while we believe it is off, e.g. powered on via IR
-        // remote, or the start of a post-shutdown self-clean cycle. When
-        // self-clean reporting is configured, query it first: the SELF_CLEAN
-        // response is processed before the MODE response below, so a running
-        // cycle keeps the entity OFF (the MODE response is ignored while
-        // self-clean is running).
-        if (this->self_clean_sensor_ != nullptr) {
-          this->requestData(ToshibaCommandType::SELF_CLEAN);
-        }
-        this->requestData(ToshibaCommandType::MODE);
+#endif
+      } else if (this->mode == climate::CLIMATE_MODE_OFF && climateState == STATE::ON &&
+                 !this->transactions_.is_running(ToshibaCommandType::POWER_STATE)) {
+        // a running transaction (end of self-clean) handles the reply itself
+        this->check_self_clean_then_mode_();
       }
       this->power_state_ = climateState;
       break;
     }
     case ToshibaCommandType::SELF_CLEAN: {
+#ifdef USE_TOSHIBA_SUZUMI_SELF_CLEAN
       auto self_clean_state = static_cast<SELF_CLEAN_STATE>(value);
       bool was_running = this->self_clean_running_;
       if (self_clean_state == SELF_CLEAN_STATE::RUNNING) {
@@ -442,13 +964,14 @@ void ToshibaClimateUart::parseResponse(std::vector<uint8_t> rawData) {
           // interrupted by switching the unit back on. The self-clean register
           // doesn't distinguish these, and the unit only reports power state on
           // change/query (not continuously), so the cached value may be stale.
-          // Query the power state to resync; the POWER_STATE handler refreshes
-          // the mode when the unit turns out to be on.
-          this->requestData(ToshibaCommandType::POWER_STATE);
+          // Query the power state to resync and refresh the mode when the unit
+          // turns out to be on.
+          this->transact_(ToshibaCommandType::POWER_STATE, &ToshibaClimateUart::on_self_clean_ended_);
         }
       } else {
         ESP_LOGW(TAG, "Received unknown self-clean state: %d", value);
       }
+#endif
       break;
     }
     case ToshibaCommandType::SPECIAL_MODE: {
@@ -456,7 +979,7 @@ void ToshibaClimateUart::parseResponse(std::vector<uint8_t> rawData) {
       auto preset_string = SpecialModeToPreset(this->special_mode_.value());
       ESP_LOGI(TAG, "Received special mode: %s", preset_string);
       // Only update preset if it's supported
-      if (std::find(supported_presets_.begin(), supported_presets_.end(), preset_string) != supported_presets_.end()) {
+      if (this->is_special_mode_supported_(this->special_mode_.value())) {
         auto climate_preset = SpecialModeToClimatePreset(this->special_mode_.value());
         if (climate_preset.has_value()) {
           // Use standard preset
@@ -470,76 +993,76 @@ void ToshibaClimateUart::parseResponse(std::vector<uint8_t> rawData) {
       break;
     }
     case ToshibaCommandType::ODU_STATUS: {
-      // Outdoor unit status - data offset depends on message length
-      uint8_t odu_offset = (length == 22) ? 13 : 15;
-      ESP_LOGI(TAG, "Received ODU status");
-      if (cdu_td_temp_sensor_ != nullptr) {
-        int8_t val = static_cast<int8_t>(rawData[odu_offset + 0]);
-        if (val != 127) {
-          cdu_td_temp_sensor_->publish_state(val);
-        }
-      }
-      if (cdu_ts_temp_sensor_ != nullptr) {
-        int8_t val = static_cast<int8_t>(rawData[odu_offset + 1]);
-        if (val != 127) {
-          cdu_ts_temp_sensor_->publish_state(val);
-        }
-      }
-      if (cdu_te_temp_sensor_ != nullptr) {
-        int8_t val = static_cast<int8_t>(rawData[odu_offset + 2]);
-        if (val != 127) {
-          cdu_te_temp_sensor_->publish_state(val);
-        }
-      }
-      if (cdu_load_sensor_ != nullptr) {
-        uint8_t raw_val = rawData[odu_offset + 3];
-        if (raw_val < 254) {
-          cdu_load_sensor_->publish_state(raw_val / 1.7f);
-        }
+      [[maybe_unused]] auto odu = decode_odu_status(rawData + decoded.data_offset);
+#ifdef USE_TOSHIBA_SUZUMI_ENERGY
+      this->compressor_running_ = odu.compressor_running();
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT
+      if (this->outdoor_unit_ != nullptr) {
+        // published by all units sharing the outdoor unit
+        this->outdoor_unit_->odu_status_received(this, odu);
+        break;
       }
-      if (cdu_iac_sensor_ != nullptr) {
-        uint8_t raw_val = rawData[odu_offset + 6];
-        if (raw_val < 254) {
-          cdu_iac_sensor_->publish_state(raw_val);
-        }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_ODU_STATUS
+      if (publish_status) {
+        this->publish_odu_status_(odu);
       }
+#endif
       break;
     }
     case ToshibaCommandType::IDU_STATUS: {
-      // Indoor unit status - data offset depends on message length
-      uint8_t idu_offset = (length == 22) ? 13 : 15;
+      auto idu = decode_idu_status(rawData + decoded.data_offset);
+      // fan speed jumps when the unit was switched or reconfigured by IR remote
+      if (this->last_fan_rpm_.has_value() &&
+          abs(static_cast<int>(idu.fan_rpm) - static_cast<int>(*this->last_fan_rpm_)) >= FAN_RPM_JUMP) {
+        this->start_burst_poll_("fan speed jump");
+      }
+      this->last_fan_rpm_ = idu.fan_rpm;
+#ifdef USE_TOSHIBA_SUZUMI_IDU_STATUS
+      if (!publish_status) {
+        break;
+      }
       ESP_LOGI(TAG, "Received IDU status");
-      if (fcu_tc_temp_sensor_ != nullptr) {
-        int8_t val = static_cast<int8_t>(rawData[idu_offset + 0]);
-        if (val != 127) {
-          fcu_tc_temp_sensor_->publish_state(val);
-        }
+      if (fcu_tc_temp_sensor_ != nullptr && idu.tc != TEMP_UNKNOWN) {
+        fcu_tc_temp_sensor_->publish_state(idu.tc);
       }
-      if (fcu_tcj_temp_sensor_ != nullptr) {
-        int8_t val = static_cast<int8_t>(rawData[idu_offset + 1]);
-        if (val != 127) {
-          fcu_tcj_temp_sensor_->publish_state(val);
-        }
+      if (fcu_tcj_temp_sensor_ != nullptr && idu.tcj != TEMP_UNKNOWN) {
+        fcu_tcj_temp_sensor_->publish_state(idu.tcj);
       }
       if (fcu_fan_rpm_sensor_ != nullptr) {
-        fcu_fan_rpm_sensor_->publish_state(rawData[idu_offset + 2]);
+        fcu_fan_rpm_sensor_->publish_state(idu.fan_rpm);
       }
+#endif
       break;
     }
     default:
-      ESP_LOGW(TAG, "Unknown sensor: %d with value %d", sensor, value);
+      ESP_LOGW(TAG, "Unknown sensor: %d with value %d", static_cast<uint8_t>(sensor), value);
       break;
   }
-  this->rx_message_.clear();  // message processed, clear buffer
-  this->publish_state();      // publish current values to MQTT
+  {
+    TOSHIBA_PROFILE(PUBLISH);
+    this->publish_state();  // publish current values to MQTT
+  }
+  if (reply) {
+    this->transactions_.complete(this, sensor, value);
+  }
 }
 
 void ToshibaClimateUart::dump_config() {
   ESP_LOGCONFIG(TAG, "ToshibaClimate:");
   LOG_CLIMATE("", "Thermostat", this);
+#ifdef USE_TOSHIBA_SUZUMI_INDOOR_TEMP
+  if (indoor_temp_sensor_ != nullptr) {
+    LOG_SENSOR("", "Indoor Temp", this->indoor_temp_sensor_);
+  }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_TEMP
   if (outdoor_temp_sensor_ != nullptr) {
     LOG_SENSOR("", "Outdoor Temp", this->outdoor_temp_sensor_);
   }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_ODU_STATUS
   if (cdu_td_temp_sensor_ != nullptr) {
     LOG_SENSOR("", "CDU Td Temp", this->cdu_td_temp_sensor_);
   }
@@ -555,6 +1078,8 @@ void ToshibaClimateUart::dump_config() {
   if (cdu_iac_sensor_ != nullptr) {
     LOG_SENSOR("", "CDU IAC", this->cdu_iac_sensor_);
   }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_IDU_STATUS
   if (fcu_tc_temp_sensor_ != nullptr) {
     LOG_SENSOR("", "FCU Tc Temp", this->fcu_tc_temp_sensor_);
   }
@@ -564,28 +1089,139 @@ void ToshibaClimateUart::dump_config() {
   if (fcu_fan_rpm_sensor_ != nullptr) {
     LOG_SENSOR("", "FCU Fan RPM", this->fcu_fan_rpm_sensor_);
   }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_ENERGY
   if (energy_sensor_ != nullptr) {
     LOG_SENSOR("", "Energy", this->energy_sensor_);
   }
   if (power_sensor_ != nullptr) {
     LOG_SENSOR("", "Power", this->power_sensor_);
   }
+  if (lifetime_energy_sensor_ != nullptr) {
+    LOG_SENSOR("", "Lifetime Energy", this->lifetime_energy_sensor_);
+  }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_PWR_SELECT
   if (pwr_select_ != nullptr) {
     LOG_SELECT("", "Power selector", this->pwr_select_);
   }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_VERTICAL_AIR_DIRECTION
   if (vertical_air_direction_select_ != nullptr) {
     LOG_SELECT("", "Vertical air direction", this->vertical_air_direction_select_);
   }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_SELF_CLEAN
   if (self_clean_sensor_ != nullptr) {
     LOG_BINARY_SENSOR("", "Self Clean", this->self_clean_sensor_);
   }
-  if (!supported_presets_.empty()) {
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_CONNECTED
+  if (connected_sensor_ != nullptr) {
+    LOG_BINARY_SENSOR("", "Connected", this->connected_sensor_);
+  }
+#endif
+  if (this->supported_special_modes_ != 0) {
     ESP_LOGCONFIG(TAG, "Supported presets:");
-    for (const char* &preset : supported_presets_) {
-      ESP_LOGCONFIG(TAG, "  - %s", preset);
+    for (size_t i = 0; i < SPECIAL_MODE_TABLE.size(); i++) {
+      if (this->is_special_mode_supported_(SPECIAL_MODE_TABLE[i].value)) {
+        ESP_LOGCONFIG(TAG, "  - %s", SPECIAL_MODE_TABLE[i].name);
+      }
     }
   }
   ESP_LOGI(TAG, "Min Temp: %d", this->min_temp_);
+  ESP_LOGCONFIG(TAG, "Loop budget: %" PRIu32 "us", this->loop_budget_us_);
+#ifdef USE_TOSHIBA_SUZUMI_PROFILE
+  ESP_LOGCONFIG(TAG, "Profile interval: %" PRIu32 "ms", this->profile_interval_);
+  this->profiler_.log("Profile since the last period");
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_RX_TASK
+  ESP_LOGCONFIG(TAG, "UART RX task: %s", this->rx_task_.is_running() ? "running" : "not running");
+#endif
+  ESP_LOGCONFIG(TAG, "Instance size: %u bytes", (unsigned) sizeof(*this));
+  // registers 128-255, '+' supported, '-' not supported, '.' unknown
+  char map[129];
+  for (uint16_t reg = 128; reg < 256; reg++) {
+    auto cmd = static_cast<ToshibaCommandType>(reg);
+    map[reg - 128] = this->capabilities_.is_supported(cmd) ? '+' : this->capabilities_.is_unsupported(cmd) ? '-' : '.';
+  }
+  map[128] = '\0';
+  ESP_LOGCONFIG(TAG, "Registers 128-191: %.64s", map);
+  ESP_LOGCONFIG(TAG, "Registers 192-255: %s", map + 64);
+#ifdef USE_TOSHIBA_SUZUMI_LINK_STATS
+  if (this->has_link_stats_sensors_()) {
+    ESP_LOGCONFIG(TAG, "Link stats update interval: %" PRIu32 "ms", this->link_stats_interval_);
+    LOG_SENSOR("  ", "Frames sent", this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::FRAMES_SENT)]);
+    LOG_SENSOR("  ", "Frames received", this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::FRAMES_RECEIVED)]);
+    LOG_SENSOR("  ", "Checksum errors", this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::CHECKSUM_ERRORS)]);
+    LOG_SENSOR("  ", "RX timeouts", this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::RX_TIMEOUTS)]);
+    LOG_SENSOR("  ", "Unknown frames", this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::UNKNOWN_FRAMES)]);
+    LOG_SENSOR("  ", "Queue depth", this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::QUEUE_DEPTH)]);
+    LOG_SENSOR("  ", "Queue high watermark",
+               this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::QUEUE_HIGH_WATERMARK)]);
+    LOG_SENSOR("  ", "Command wait p50", this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::COMMAND_WAIT_P50)]);
+    LOG_SENSOR("  ", "Command wait p95", this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::COMMAND_WAIT_P95)]);
+    LOG_SENSOR("  ", "Round trip p50", this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::ROUND_TRIP_P50)]);
+    LOG_SENSOR("  ", "Round trip p95", this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::ROUND_TRIP_P95)]);
+    LOG_SENSOR("  ", "Peak loop time", this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::PEAK_LOOP_TIME)]);
+    LOG_SENSOR("  ", "Reconnects", this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::RECONNECTS)]);
+    LOG_SENSOR("  ", "Control to wire p50",
+               this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::CONTROL_TO_WIRE_P50)]);
+    LOG_SENSOR("  ", "Control to wire p99",
+               this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::CONTROL_TO_WIRE_P99)]);
+    LOG_SENSOR("  ", "Control to confirm p50",
+               this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::CONTROL_TO_CONFIRM_P50)]);
+    LOG_SENSOR("  ", "Control to confirm p99",
+               this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::CONTROL_TO_CONFIRM_P99)]);
+    LOG_SENSOR("  ", "Unsolicited frames",
+               this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::UNSOLICITED_FRAMES)]);
+    LOG_SENSOR("  ", "Elided writes", this->link_stats_sensors_[static_cast<uint8_t>(LinkStat::ELIDED_WRITES)]);
+  }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_LATENCY_REPORT
+  if (this->latency_report_interval_ != 0) {
+    ESP_LOGCONFIG(TAG, "Latency report interval: %" PRIu32 "ms", this->latency_report_interval_);
+  }
+#endif
+  if (ToshibaPollScheduler::unit_count() > 1) {
+    ESP_LOGCONFIG(TAG, "Unit slot: %u of %u", this->unit_slot_ + 1, ToshibaPollScheduler::unit_count());
+  }
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT
+  if (this->outdoor_unit_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "Shared outdoor unit, reads outdoor telemetry: %s",
+                  this->outdoor_unit_->is_leader(this) ? "yes" : "no");
+  }
+#endif
+}
+
+/**
+ * Schedule the periodic poll. When more units are handled by this node, polls
+ * are staggered across the update interval according to the unit's slot.
+ */
+void ToshibaClimateUart::update() {
+  if (this->link_lost_) {
+    // reconnect is scheduled, don't queue polls into silence
+    return;
+  }
+  if (ToshibaPollScheduler::unit_count() < 2) {
+    this->poll_();
+    return;
+  }
+  this->poll_at_ = millis() + ToshibaPollScheduler::poll_offset(this->unit_slot_, this->get_update_interval());
+  this->poll_pending_ = true;
+}
+
+void ToshibaClimateUart::run_deadlines_(uint32_t now) {
+  if (this->poll_pending_ && (int32_t) (now - this->poll_at_) >= 0) {
+    this->poll_pending_ = false;
+    this->poll_();
+  }
+  if (this->burst_polls_left_ != 0 && now - this->burst_polled_at_ >= BURST_POLL_INTERVAL) {
+    this->burst_poll_();
+  }
+  if (this->capabilities_dirty_ && now - this->capabilities_changed_at_ >= CAPABILITIES_SAVE_DELAY) {
+    this->save_capabilities_();
+  }
 }
 
 /**
@@ -593,40 +1229,52 @@ void ToshibaClimateUart::dump_config() {
  * It servers two purposes - updates data and is like "watchdog" because
  * some people reported that without communication, the unit might stop responding.
  */
-void ToshibaClimateUart::update() {
+void ToshibaClimateUart::poll_() {
+  // cheap detector of changes made by IR remote, starts burst polling of other settings
+  this->requestData(ToshibaCommandType::POWER_STATE);
   this->requestData(ToshibaCommandType::ROOM_TEMP);
-  if (outdoor_temp_sensor_ != nullptr) {
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_TEMP
+  if (this->reads_outdoor_temp_()) {
     this->requestData(ToshibaCommandType::OUTDOOR_TEMP);
   }
+#endif
   if (this->self_clean_running_) {
     this->requestData(ToshibaCommandType::SELF_CLEAN);
   }
 
+#if defined(USE_TOSHIBA_SUZUMI_TIME_SYNC) || defined(USE_TOSHIBA_SUZUMI_ENERGY)
   uint32_t now = millis();
+#endif
 
-#ifdef USE_TIME
+#ifdef USE_TOSHIBA_SUZUMI_TIME_SYNC
   // Handle time synchronization
   if (this->time_ != nullptr) {
     this->check_time_sync_(now);
   }
 #endif
 
-  // Periodic Energy Sync (Runs every 60s if energy or power sensors are configured)
-  if ((this->energy_sensor_ != nullptr || this->power_sensor_ != nullptr) && (now - this->last_energy_sync_ > 60000)) {
-    this->sync_energy_();
+#ifdef USE_TOSHIBA_SUZUMI_ENERGY
+  if (this->energy_dirty_ && now - this->last_energy_save_ > ENERGY_SAVE_INTERVAL) {
+    this->save_energy_state_();
   }
+#endif
 }
 
 void ToshibaClimateUart::control(const climate::ClimateCall &call) {
+  TOSHIBA_PROFILE(CONTROL);
+  // settings changed together are applied by the unit at once
+  this->begin_writes_();
   if (call.get_mode().has_value()) {
     ClimateMode mode = *call.get_mode();
-    ESP_LOGD(TAG, "Setting mode to %s", climate_mode_to_string(mode));
+    ESP_LOGD(TAG, "Setting mode to %s", LOG_STR_ARG(climate_mode_to_string(mode)));
     if (mode != CLIMATE_MODE_OFF) {
       this->set_self_clean_running_(false);
     }
     if (this->mode == CLIMATE_MODE_OFF && mode != CLIMATE_MODE_OFF) {
       ESP_LOGD(TAG, "Setting AC unit power state to ON.");
-      this->sendCmd(ToshibaCommandType::POWER_STATE, static_cast<uint8_t>(STATE::ON));
+      // always written: during self-clean the unit reports ON while the entity is OFF,
+      // the write interrupts the cleaning cycle
+      this->sendCmd(ToshibaCommandType::POWER_STATE, static_cast<uint8_t>(STATE::ON), true);
     }
     if (mode == CLIMATE_MODE_OFF) {
       ESP_LOGD(TAG, "Setting AC unit power state to OFF.");
@@ -660,7 +1308,7 @@ void ToshibaClimateUart::control(const climate::ClimateCall &call) {
 
     ESP_LOGD(TAG, "Setting target temp to %d", newTargetTemp);
     if (this->special_mode_ == SPECIAL_MODE::EIGHT_DEG) {
-      newTargetTemp += SPECIAL_TEMP_OFFSET;
+      newTargetTemp = encode_target_temp(newTargetTemp, true);
       ESP_LOGD(TAG, "Note: Special Mode \"%s\" active, shifting setpoint temp to %d", SPECIAL_MODE_EIGHT_DEG,
                newTargetTemp);
     }
@@ -673,7 +1321,7 @@ void ToshibaClimateUart::control(const climate::ClimateCall &call) {
 
   if (call.get_fan_mode().has_value()) {
     auto fan_mode = *call.get_fan_mode();
-    ESP_LOGD(TAG, "Setting fan mode to %s", climate_fan_mode_to_string(fan_mode));
+    ESP_LOGD(TAG, "Setting fan mode to %s", LOG_STR_ARG(climate_fan_mode_to_string(fan_mode)));
     this->set_fan_mode_(fan_mode);
     auto fan_value = ClimateFanModeToInt(fan_mode);
     if (fan_value.has_value()) {
@@ -694,7 +1342,7 @@ void ToshibaClimateUart::control(const climate::ClimateCall &call) {
   if (call.get_swing_mode().has_value()) {
     auto swing_mode = *call.get_swing_mode();
     auto function_value = ClimateSwingModeToInt(swing_mode);
-    ESP_LOGD(TAG, "Setting swing mode to %s", climate_swing_mode_to_string(swing_mode));
+    ESP_LOGD(TAG, "Setting swing mode to %s", LOG_STR_ARG(climate_swing_mode_to_string(swing_mode)));
     this->swing_mode = swing_mode;
     this->sendCmd(ToshibaCommandType::SWING, static_cast<uint8_t>(function_value));
     this->publish_vertical_air_direction_(function_value);
@@ -704,7 +1352,7 @@ void ToshibaClimateUart::control(const climate::ClimateCall &call) {
     auto preset = *call.get_preset();
     auto preset_string = ClimatePresetToString(preset);
     ESP_LOGD(TAG, "Setting preset to %s", preset_string);
-    auto special_mode = PresetToSpecialMode(preset_string);
+    auto special_mode = ClimatePresetToSpecialMode(preset);
     if (special_mode.has_value()) {
       this->sendCmd(ToshibaCommandType::SPECIAL_MODE, static_cast<uint8_t>(special_mode.value()));
       // Set standard preset
@@ -757,11 +1405,23 @@ void ToshibaClimateUart::control(const climate::ClimateCall &call) {
     }
   }
 
-  this->publish_state();
+  this->flush_writes_();
+  {
+    TOSHIBA_PROFILE(PUBLISH);
+    this->publish_state();
+  }
 }
 
 ClimateTraits ToshibaClimateUart::traits() {
-  auto traits = climate::ClimateTraits();
+  if (!this->traits_built_) {
+    this->build_traits_();
+  }
+  return this->traits_;
+}
+
+void ToshibaClimateUart::build_traits_() {
+  auto &traits = this->traits_;
+  traits = climate::ClimateTraits();
 
   if (this -> heat_mode_disabled_) {
     traits.set_supported_modes({
@@ -806,29 +1466,31 @@ ClimateTraits ToshibaClimateUart::traits() {
   traits.set_visual_max_temperature(MAX_TEMP);
 
   // Add supported standard presets based on configuration (custom presets are set in setup())
-  if (!this->supported_presets_.empty()) {
-    for (const char *preset_string : this->supported_presets_) {
-      auto climate_preset = StringToClimatePreset(preset_string);
-      if (climate_preset.has_value()) {
-        // preset is supported by the climate component
-        traits.add_supported_preset(*climate_preset);
-      }
+  for (size_t i = 0; i < SPECIAL_MODE_TABLE.size(); i++) {
+    auto const &mode = SPECIAL_MODE_TABLE[i];
+    auto climate_preset = SpecialModeToClimatePreset(mode.value);
+    if (this->is_special_mode_supported_(mode.value) && climate_preset.has_value()) {
+      // preset is supported by the climate component
+      traits.add_supported_preset(*climate_preset);
     }
   }
-  return traits;
+  this->traits_built_ = true;
 }
 
+#ifdef USE_TOSHIBA_SUZUMI_PWR_SELECT
 void ToshibaClimateUart::on_set_pwr_level(const std::string &value) {
   ESP_LOGD(TAG, "Setting power level to %s", value.c_str());
-  auto pwr_level = StringToPwrLevel(value);
+  auto pwr_level = StringToPwrLevel(value.c_str());
   this->sendCmd(ToshibaCommandType::POWER_SEL, static_cast<uint8_t>(pwr_level.value()));
   pwr_select_->publish_state(value);
 }
 
 void ToshibaPwrModeSelect::control(const std::string &value) { parent_->on_set_pwr_level(value); }
+#endif
 
+#ifdef USE_TOSHIBA_SUZUMI_VERTICAL_AIR_DIRECTION
 void ToshibaClimateUart::on_set_vertical_air_direction(const std::string &value) {
-  auto position = StringToVerticalAirDirection(value);
+  auto position = StringToVerticalAirDirection(value.c_str());
   if (!position.has_value()) {
     ESP_LOGW(TAG, "Unknown vertical air direction: %s", value.c_str());
     return;
@@ -842,10 +1504,15 @@ void ToshibaClimateUart::on_set_vertical_air_direction(const std::string &value)
   } else {
     this->swing_mode = climate::CLIMATE_SWING_OFF;
   }
+  TOSHIBA_PROFILE(PUBLISH);
   this->publish_state();
 }
 
-void ToshibaClimateUart::publish_vertical_air_direction_(SWING swing_mode) {
+void ToshibaVerticalAirDirectionSelect::control(const std::string &value) { parent_->on_set_vertical_air_direction(value); }
+#endif
+
+void ToshibaClimateUart::publish_vertical_air_direction_([[maybe_unused]] SWING swing_mode) {
+#ifdef USE_TOSHIBA_SUZUMI_VERTICAL_AIR_DIRECTION
   if (vertical_air_direction_select_ == nullptr) {
     return;
   }
@@ -853,24 +1520,109 @@ void ToshibaClimateUart::publish_vertical_air_direction_(SWING swing_mode) {
   if (position != nullptr) {
     vertical_air_direction_select_->publish_state(position);
   }
+#endif
 }
 
-void ToshibaVerticalAirDirectionSelect::control(const std::string &value) { parent_->on_set_vertical_air_direction(value); }
+#ifdef USE_TOSHIBA_SUZUMI_RAW_REGISTER
+void ToshibaClimateUart::read_register(uint8_t reg) {
+  if (this->find_raw_read_(reg) == nullptr) {
+    if (this->raw_read_count_ == RAW_READS_MAX) {
+      ESP_LOGW(TAG, "Too many raw reads pending, not reading register %u", reg);
+      return;
+    }
+    this->raw_reads_[this->raw_read_count_++] = RawRead{.reg = reg, .sent = false, .sent_at = 0};
+  }
+  if (!this->requestData(static_cast<ToshibaCommandType>(reg), true)) {
+    this->remove_raw_read_(this->find_raw_read_(reg));
+  }
+}
+
+void ToshibaClimateUart::write_register(uint8_t reg, uint8_t value) {
+  this->sendCmd(static_cast<ToshibaCommandType>(reg), value, true);
+  this->read_register(reg);
+}
+
+ToshibaClimateUart::RawRead *ToshibaClimateUart::find_raw_read_(uint8_t reg) {
+  for (uint8_t i = 0; i < this->raw_read_count_; i++) {
+    if (this->raw_reads_[i].reg == reg) {
+      return &this->raw_reads_[i];
+    }
+  }
+  return nullptr;
+}
+
+void ToshibaClimateUart::remove_raw_read_(RawRead *read) {
+  *read = this->raw_reads_[--this->raw_read_count_];
+}
+
+/// The READ frame of the register was sent, its reply is waited for from now on.
+void ToshibaClimateUart::raw_read_sent_(uint8_t reg, uint32_t now) {
+  auto *read = this->find_raw_read_(reg);
+  if (read != nullptr) {
+    read->sent = true;
+    read->sent_at = now;
+  }
+}
+
+bool ToshibaClimateUart::take_raw_request_(uint8_t reg) {
+  auto *read = this->find_raw_read_(reg);
+  if (read == nullptr) {
+    return false;
+  }
+  this->remove_raw_read_(read);
+  return true;
+}
+
+/// Expiry of the oldest sent raw read, reads still in the queue have none yet.
+optional<uint32_t> ToshibaClimateUart::next_raw_read_deadline_() const {
+  optional<uint32_t> deadline;
+  for (uint8_t i = 0; i < this->raw_read_count_; i++) {
+    const auto &read = this->raw_reads_[i];
+    uint32_t expires = read.sent_at + ToshibaTransactions::TIMEOUT + 1;
+    if (read.sent && (!deadline.has_value() || (int32_t) (expires - *deadline) < 0)) {
+      deadline = expires;
+    }
+  }
+  return deadline;
+}
+
+/**
+ * Drop raw reads the unit didn't answer (unknown register), so a frame of the register
+ * pushed later by the unit doesn't fire on_register_value.
+ */
+void ToshibaClimateUart::expire_raw_requests_(uint32_t now) {
+  for (uint8_t i = 0; i < this->raw_read_count_;) {
+    auto &read = this->raw_reads_[i];
+    if (read.sent && now - read.sent_at > ToshibaTransactions::TIMEOUT) {
+      ESP_LOGW(TAG, "No reply to the read of register %u", read.reg);
+      this->remove_raw_read_(&read);
+    } else {
+      i++;
+    }
+  }
+}
+#endif
 
 /**
  * Scan all statuses from 128 to 255 in order to find unknown features.
+ * Registers are requested one by one as the queue drains (see process_command_queue_).
  */
 void ToshibaClimateUart::scan() {
   ESP_LOGI(TAG, "Scan started.");
-  for (uint8_t i = 128; i < 255; i++) {
-    this->requestData(static_cast<ToshibaCommandType>(i));
-  }
+  this->scan_register_ = 128;
+  this->process_command_queue_();
 }
 
 /**
  * Expose Wi-Fi LED control
  */
-void ToshibaClimateUart::set_wifi_led(bool enabled) {
+void ToshibaClimateUart::set_wifi_led(bool enabled, bool force) {
+  if (!force && !this->force_writes_ && this->wifi_led_ == enabled) {
+    ESP_LOGD(TAG, "Wi-Fi LED is already %s", enabled ? "ON" : "OFF");
+    this->link_stats_.elided_writes += 2;
+    return;
+  }
+  this->wifi_led_ = enabled;
   if (enabled) {
     ESP_LOGI(TAG, "Turning ON Wi-Fi LED");
     this->sendCmd(ToshibaCommandType::WIFI_LED_1, 0x05);
@@ -882,7 +1634,7 @@ void ToshibaClimateUart::set_wifi_led(bool enabled) {
   }
 }
 
-#ifdef USE_TIME
+#ifdef USE_TOSHIBA_SUZUMI_TIME_SYNC
 void ToshibaClimateUart::check_time_sync_(uint32_t now) {
   if (!this->time_synced_) {
     // Boot sync or retry every 5 minutes until synchronized
@@ -916,34 +1668,174 @@ void ToshibaClimateUart::sync_time_() {
   ESP_LOGI(TAG, "Syncing time to AC unit: %04d-%02d-%02d %02d:%02d:%02d", now.year, now.month, now.day_of_month, now.hour,
            now.minute, now.second);
 
-  std::vector<uint8_t> payload = {2, 0, 3, 16, 0, 0, 0xef, 1, 48, 1, 0, 0xea, 0x99};
-  payload.push_back((now.year - 2000) + 100);
-  payload.push_back(now.month - 1);
-  payload.push_back(now.day_of_month);
-  payload.push_back(now.hour);
-  payload.push_back(now.minute);
-  payload.push_back(now.second);
-  payload.push_back(now.day_of_week - 1); // Sunday=0
-  payload.push_back(0x00);
-  payload.push_back(0x00);
-  for (int i = 0; i < 224; i++) {
-    payload.push_back(0xFF);
-  }
-  payload.push_back(checksum(payload, payload.size()));
-
   // Enqueue the time sync packet and a 5-second delay to prevent collisions
-  this->enqueue_command_(ToshibaCommand{.cmd = ToshibaCommandType::SET_DATE_TIME, .payload = payload});
-  this->enqueue_command_(ToshibaCommand{.cmd = ToshibaCommandType::DELAY, .delay = 5000});
+  this->enqueue_command_(
+      ToshibaCommand{.cmd = ToshibaCommandType::SET_DATE_TIME, .action = ToshibaCommandAction::TIME_SYNC});
+  this->enqueue_command_(
+      ToshibaCommand{.cmd = ToshibaCommandType::DELAY, .action = ToshibaCommandAction::DELAY, .delay = 5000});
   this->last_time_sync_ = millis();
 }
+
+/**
+ * Send the time sync frame with the current time. The frame is padded by 224 bytes of 0xFF,
+ * which are written from a constant chunk instead of building the whole frame in memory.
+ */
+void ToshibaClimateUart::send_time_() {
+  static const uint8_t PADDING[32] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  static const uint8_t PADDING_LENGTH = 224;
+  auto now = this->time_->now();
+  uint8_t header[] = {2,
+                      0,
+                      3,
+                      16,
+                      0,
+                      0,
+                      0xef,
+                      1,
+                      48,
+                      1,
+                      0,
+                      0xea,
+                      0x99,
+                      static_cast<uint8_t>((now.year - 2000) + 100),
+                      static_cast<uint8_t>(now.month - 1),
+                      now.day_of_month,
+                      now.hour,
+                      now.minute,
+                      now.second,
+                      static_cast<uint8_t>(now.day_of_week - 1),  // Sunday=0
+                      0x00,
+                      0x00};
+  uint8_t sum = 256 - checksum(header, sizeof(header));
+  for (uint8_t i = 0; i < PADDING_LENGTH; i++) {
+    sum += 0xFF;
+  }
+  uint8_t crc = 256 - sum;
+
+  this->write_frame_(header, sizeof(header));
+  for (uint8_t written = 0; written < PADDING_LENGTH; written += sizeof(PADDING)) {
+    this->write_array(PADDING, sizeof(PADDING));
+  }
+  this->write_array(&crc, 1);
+}
+#endif
+
+/**
+ * The unit shares the outdoor unit with other units and another one reads the outdoor telemetry.
+ */
+bool ToshibaClimateUart::is_outdoor_follower_() const {
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT
+  return this->outdoor_unit_ != nullptr && !this->outdoor_unit_->is_leader(this);
+#else
+  return false;
+#endif
+}
+
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_TEMP
+/**
+ * Outdoor temperature is read when the unit publishes it. On a shared outdoor unit
+ * only the leader reads it, when any of the units publishes it.
+ */
+bool ToshibaClimateUart::reads_outdoor_temp_() const {
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT
+  if (this->outdoor_unit_ != nullptr) {
+    return this->outdoor_unit_->is_leader(this) && this->outdoor_unit_->needs_outdoor_temp();
+  }
+#endif
+  return this->outdoor_temp_sensor_ != nullptr;
+}
+
+void ToshibaClimateUart::publish_outdoor_temp_(int8_t value) {
+  if (this->outdoor_temp_sensor_ != nullptr) {
+    ESP_LOGI(TAG, "Received outdoor temp: %d °C", value);
+    this->outdoor_temp_sensor_->publish_state(value);
+  }
+}
+#endif
+
+#ifdef USE_TOSHIBA_SUZUMI_ODU_STATUS
+/**
+ * Publish outdoor unit status, values the unit doesn't know are skipped.
+ */
+void ToshibaClimateUart::publish_odu_status_(const ToshibaOduStatus &status) {
+  ESP_LOGI(TAG, "Received ODU status");
+  if (cdu_td_temp_sensor_ != nullptr && status.td != TEMP_UNKNOWN) {
+    cdu_td_temp_sensor_->publish_state(status.td);
+  }
+  if (cdu_ts_temp_sensor_ != nullptr && status.ts != TEMP_UNKNOWN) {
+    cdu_ts_temp_sensor_->publish_state(status.ts);
+  }
+  if (cdu_te_temp_sensor_ != nullptr && status.te != TEMP_UNKNOWN) {
+    cdu_te_temp_sensor_->publish_state(status.te);
+  }
+  if (cdu_load_sensor_ != nullptr && status.has_load()) {
+    cdu_load_sensor_->publish_state(status.load_percent());
+  }
+  if (cdu_iac_sensor_ != nullptr && status.has_iac()) {
+    cdu_iac_sensor_->publish_state(status.iac);
+  }
+}
 #endif
 
+#ifdef USE_TOSHIBA_SUZUMI_ENERGY
 void ToshibaClimateUart::sync_energy_() {
-  ESP_LOGV(TAG, "Syncing energy data");
-  this->requestData(ToshibaCommandType::ENERGY_DAILY);
+  if (this->has_energy_sensors_() && !this->link_lost_) {
+    ESP_LOGV(TAG, "Syncing energy data");
+    this->requestData(ToshibaCommandType::ENERGY_DAILY);
+  }
   this->last_energy_sync_ = millis();
 }
 
+/**
+ * Energy changes only while the unit consumes power, so the large ENERGY_DAILY frame is read
+ * often while the compressor runs and rarely while the unit is off.
+ */
+uint32_t ToshibaClimateUart::energy_demand_interval_() const {
+  if (this->mode == CLIMATE_MODE_OFF || this->self_clean_running_) {
+    return ENERGY_SYNC_OFF;
+  }
+  if (!this->compressor_running_.has_value()) {
+    return ENERGY_SYNC_ON;
+  }
+  return *this->compressor_running_ ? ENERGY_SYNC_RUNNING : ENERGY_SYNC_IDLE;
+}
+
+/**
+ * Refresh energy when the interval of the current demand elapsed, and once within the lead before
+ * each full hour (from the time source).
+ */
+void ToshibaClimateUart::check_energy_sync_() {
+  uint32_t interval = this->energy_demand_interval_();
+  if (interval != this->energy_sync_interval_) {
+    ESP_LOGV(TAG, "Energy refresh interval changed to %" PRIu32 "s", interval / 1000);
+    this->energy_sync_interval_ = interval;
+  }
+  uint32_t elapsed = millis() - this->last_energy_sync_;
+  bool due = elapsed >= interval;
+#ifdef USE_TOSHIBA_SUZUMI_TIME_SYNC
+  if (!due && elapsed >= ENERGY_SYNC_HOUR_LEAD && this->time_ != nullptr) {
+    auto now = this->time_->now();
+    due = now.is_valid() && now.minute == 59 && (60u - now.second) * 1000 <= ENERGY_SYNC_HOUR_LEAD;
+  }
+#endif
+  if (due) {
+    this->sync_energy_();
+  }
+}
+
+void ToshibaClimateUart::publish_power_(float watts) {
+  if (this->power_sensor_ != nullptr) {
+    this->power_sensor_->publish_state(watts);
+  }
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT
+  if (this->outdoor_unit_ != nullptr) {
+    this->outdoor_unit_->power_estimated(this, watts);
+  }
+#endif
+}
+
 void ToshibaClimateUart::estimate_wattage_(uint32_t current_energy) {
   uint32_t now = millis();
   if (this->last_energy_update_ms_ == 0 || current_energy < this->last_total_daily_energy_) {
@@ -956,19 +1848,228 @@ void ToshibaClimateUart::estimate_wattage_(uint32_t current_energy) {
   uint32_t time_diff = now - this->last_energy_update_ms_;
 
   if (time_diff > 0 && energy_diff > 0) {
-    float wattage = (energy_diff * 3600000.0f) / time_diff;
-    if (this->power_sensor_ != nullptr) {
-      this->power_sensor_->publish_state(wattage);
-    }
+    this->publish_power_((energy_diff * 3600000.0f) / time_diff);
   } else if (energy_diff == 0) {
-    if (this->power_sensor_ != nullptr) {
-      this->power_sensor_->publish_state(0);
-    }
+    this->publish_power_(0);
   }
 
   this->last_total_daily_energy_ = current_energy;
   this->last_energy_update_ms_ = now;
 }
 
+/**
+ * Add consumption since the previous ENERGY_DAILY frame to the lifetime counter.
+ * Per-hour values only grow during the day, so the delta is the sum of their increments.
+ * At midnight the unit starts a new day and the hours up to now belong to the new day.
+ */
+void ToshibaClimateUart::update_lifetime_energy_(const uint16_t *hours) {
+  auto &state = this->energy_state_;
+  uint8_t day = 0;
+  uint8_t hour = 23;
+#ifdef USE_TOSHIBA_SUZUMI_TIME_SYNC
+  if (this->time_ != nullptr) {
+    auto now = this->time_->now();
+    if (now.is_valid()) {
+      // give the unit time to roll its own day over
+      if (state.day != 0 && now.day_of_month != state.day && now.hour == 0 && now.minute < 2) {
+        return;
+      }
+      day = now.day_of_month;
+      hour = now.hour;
+    }
+  }
+#endif
+  bool new_day = day != 0 && state.day != 0 && day != state.day;
+  uint32_t delta = 0;
+  for (uint8_t i = 0; i < 24; i++) {
+    if (new_day) {
+      if (i <= hour) {
+        delta += hours[i];
+      }
+    } else if (hours[i] >= state.hours[i]) {
+      delta += hours[i] - state.hours[i];
+    } else {
+      // hour was reset by day rollover we did not see (no valid clock)
+      delta += hours[i];
+    }
+  }
+  if (!this->energy_baseline_) {
+    // nothing to compare with, start counting from this frame
+    delta = 0;
+    this->energy_baseline_ = true;
+  }
+  if (delta > 0 || new_day || day != state.day) {
+    this->energy_dirty_ = true;
+  }
+  memcpy(state.hours, hours, sizeof(state.hours));
+  state.day = day;
+  state.lifetime += delta;
+  ESP_LOGD(TAG, "Lifetime energy: %" PRIu32 " Wh (+%" PRIu32 " Wh)", state.lifetime, delta);
+  this->lifetime_energy_sensor_->publish_state(state.lifetime);
+}
+
+void ToshibaClimateUart::save_energy_state_() {
+  ESP_LOGD(TAG, "Saving lifetime energy: %" PRIu32 " Wh", this->energy_state_.lifetime);
+  this->energy_pref_.save(&this->energy_state_);
+  this->energy_dirty_ = false;
+  this->last_energy_save_ = millis();
+}
+
+void ToshibaClimateUart::on_shutdown() {
+  if (this->energy_dirty_) {
+    this->save_energy_state_();
+  }
+}
+#endif
+
+#ifdef USE_TOSHIBA_SUZUMI_CAPTURE
+void ToshibaClimateUart::start_capture(uint32_t duration, uint32_t interval) {
+  ESP_LOGI(TAG, "Starting capture for %" PRIu32 "s, sampling every %" PRIu32 "ms", duration / 1000, interval);
+  this->capture_.start(interval, millis());
+  this->capture_duration_ = duration;
+  this->set_interval("capture", interval, [this]() { this->capture_tick_(); });
+  this->capture_tick_();
+}
+
+void ToshibaClimateUart::stop_capture() {
+  if (!this->capture_.is_running()) {
+    return;
+  }
+  this->capture_.stop();
+  this->cancel_interval("capture");
+  ESP_LOGI(TAG, "Capture finished, %u samples stored", this->capture_.size());
+}
+
+void ToshibaClimateUart::export_capture() {
+  this->stop_capture();
+  this->capture_.begin_export();
+  // a few lines per loop, so the log and the API keep up
+  this->set_interval("capture_export", 20, [this]() {
+    if (!this->capture_.export_lines(5)) {
+      this->cancel_interval("capture_export");
+    }
+  });
+}
+
+void ToshibaClimateUart::capture_tick_() {
+  uint32_t now = millis();
+  if (now - this->capture_.started_at() >= this->capture_duration_ || this->link_lost_) {
+    this->stop_capture();
+    return;
+  }
+  // values decoded since the previous tick
+  this->capture_.sample(now);
+  if (this->line_.queue_size() < COMMAND_QUEUE_SIZE / 2) {
+    this->requestData(ToshibaCommandType::IDU_STATUS, true);
+    this->requestData(ToshibaCommandType::ODU_STATUS, true);
+  }
+}
+
+void ToshibaClimateUart::capture_status_(ToshibaCommandType status, const uint8_t *data) {
+  if (status == ToshibaCommandType::IDU_STATUS) {
+    auto idu = decode_idu_status(data);
+    this->capture_.set(ToshibaCapture::TC, idu.tc);
+    this->capture_.set(ToshibaCapture::TCJ, idu.tcj);
+    this->capture_.set(ToshibaCapture::FAN_RPM, idu.fan_rpm);
+  } else {
+    auto odu = decode_odu_status(data);
+    this->capture_.set(ToshibaCapture::TD, odu.td);
+    this->capture_.set(ToshibaCapture::TS, odu.ts);
+    this->capture_.set(ToshibaCapture::TE, odu.te);
+    this->capture_.set(ToshibaCapture::LOAD, odu.load);
+    this->capture_.set(ToshibaCapture::IAC, odu.iac);
+  }
+}
+#endif
+
+#ifdef USE_TOSHIBA_SUZUMI_LINK_STATS
+bool ToshibaClimateUart::has_link_stats_sensors_() const {
+  for (auto *sensor : this->link_stats_sensors_) {
+    if (sensor != nullptr) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Publish link statistics. Latency histograms cover the period since the previous publish.
+ */
+void ToshibaClimateUart::publish_link_stats_() {
+  auto &stats = this->link_stats_;
+  float values[static_cast<uint8_t>(LinkStat::COUNT)] = {
+      (float) stats.frames_sent,
+      (float) stats.frames_received,
+      (float) stats.checksum_errors,
+      (float) stats.rx_timeouts,
+      (float) stats.unknown_frames,
+      (float) this->line_.queue_size(),
+      (float) stats.queue_high_watermark,
+      (float) stats.command_wait.percentile(50),
+      (float) stats.command_wait.percentile(95),
+      (float) stats.round_trip.percentile(50),
+      (float) stats.round_trip.percentile(95),
+      (float) stats.peak_loop_time,
+      (float) stats.reconnects,
+      (float) stats.control_to_wire.percentile(50),
+      (float) stats.control_to_wire.percentile(99),
+      (float) stats.control_to_confirm.percentile(50),
+      (float) stats.control_to_confirm.percentile(99),
+      (float) stats.unsolicited_frames,
+      (float) stats.elided_writes,
+  };
+  for (uint8_t i = 0; i < static_cast<uint8_t>(LinkStat::COUNT); i++) {
+    if (this->link_stats_sensors_[i] != nullptr) {
+      this->link_stats_sensors_[i]->publish_state(values[i]);
+    }
+  }
+  ESP_LOGD(TAG,
+           "Link stats: sent=%" PRIu32 " received=%" PRIu32 " checksum_errors=%" PRIu32 " rx_timeouts=%" PRIu32
+           " unknown=%" PRIu32 " unsolicited=%" PRIu32 " elided=%" PRIu32,
+           stats.frames_sent, stats.frames_received, stats.checksum_errors, stats.rx_timeouts, stats.unknown_frames,
+           stats.unsolicited_frames, stats.elided_writes);
+  ESP_LOGD(TAG, "  command wait: n=%" PRIu32 " max=%" PRIu32 "ms, round trip: n=%" PRIu32 " max=%" PRIu32 "ms",
+           stats.command_wait.count(), stats.command_wait.max(), stats.round_trip.count(), stats.round_trip.max());
+  ESP_LOGD(TAG, "  peak loop time: %" PRIu32 "us, loop budget exceeded: %" PRIu32 ", reconnects: %" PRIu32,
+           stats.peak_loop_time, stats.loop_budget_exceeded, stats.reconnects);
+#ifdef USE_TOSHIBA_SUZUMI_LATENCY_REPORT
+  if (this->latency_report_interval_ != 0) {
+    this->log_latency_report_();
+  }
+#endif
+  this->reset_latency_stats_();
+}
+#endif
+
+#ifdef USE_TOSHIBA_SUZUMI_LATENCY_REPORT
+/**
+ * Log the latencies since the previous report as one JSON line, to compare builds from logs.
+ */
+void ToshibaClimateUart::log_latency_report_() const {
+  const auto &stats = this->link_stats_;
+  ESP_LOGI(TAG,
+           "Latency report: {\"command_wait\":[%" PRIu32 ",%" PRIu32 ",%" PRIu32 "],\"round_trip\":[%" PRIu32
+           ",%" PRIu32 ",%" PRIu32 "],\"control_to_wire\":[%" PRIu32 ",%" PRIu32 ",%" PRIu32 "],"
+           "\"control_to_confirm\":[%" PRIu32 ",%" PRIu32 ",%" PRIu32 "],\"queue_high_watermark\":%u,"
+           "\"peak_loop_time\":%" PRIu32 "}",
+           stats.command_wait.count(), stats.command_wait.percentile(50), stats.command_wait.percentile(99),
+           stats.round_trip.count(), stats.round_trip.percentile(50), stats.round_trip.percentile(99),
+           stats.control_to_wire.count(), stats.control_to_wire.percentile(50), stats.control_to_wire.percentile(99),
+           stats.control_to_confirm.count(), stats.control_to_confirm.percentile(50),
+           stats.control_to_confirm.percentile(99), stats.queue_high_watermark, stats.peak_loop_time);
+}
+#endif
+
+#if defined(USE_TOSHIBA_SUZUMI_LINK_STATS) || defined(USE_TOSHIBA_SUZUMI_LATENCY_REPORT)
+void ToshibaClimateUart::reset_latency_stats_() {
+  auto &stats = this->link_stats_;
+  stats.command_wait.reset();
+  stats.round_trip.reset();
+  stats.control_to_wire.reset();
+  stats.control_to_confirm.reset();
+  stats.peak_loop_time = 0;
+}
+#endif
+
 }  // namespace toshiba_suzumi
 }  // namespace esphome
@@ -1,12 +1,22 @@
 #pragma once
 
 #include "esphome/core/component.h"
+#include "esphome/core/preferences.h"
 #include "esphome/components/binary_sensor/binary_sensor.h"
 #include "esphome/components/climate/climate.h"
 #include "esphome/components/uart/uart.h"
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/components/select/select.h"
 #include "toshiba_climate_mode.h"
+#include "toshiba_capabilities.h"
+#include "toshiba_capture.h"
+#include "toshiba_control_state.h"
+#include "toshiba_link_stats.h"
+#include "toshiba_outdoor_unit.h"
+#include "toshiba_profile.h"
+#include "toshiba_protocol.h"
+#include "toshiba_rx_task.h"
+#include "toshiba_transactions.h"
 
 namespace esphome {
 namespace time {
@@ -19,26 +29,88 @@ static const char *const TAG = "ToshibaClimateUart";
 static const uint8_t MAX_TEMP = 30;
 // default min temp for units without 8° heating mode
 static const uint8_t MIN_TEMP_STANDARD = 17;
-static const uint8_t SPECIAL_TEMP_OFFSET = 16;
 static const uint8_t SPECIAL_MODE_EIGHT_DEG_MIN_TEMP = 5;
 static const uint8_t SPECIAL_MODE_EIGHT_DEG_MAX_TEMP = 13;
 static const uint8_t SPECIAL_MODE_EIGHT_DEG_DEF_TEMP = 8;
 static const uint8_t NORMAL_MODE_DEF_TEMP = 20;
 
-static const std::vector<uint8_t> HANDSHAKE[6] = {
-    {2, 255, 255, 0, 0, 0, 0, 2},       {2, 255, 255, 1, 0, 0, 1, 2, 254}, {2, 0, 0, 0, 0, 0, 2, 2, 2, 250},
-    {2, 0, 1, 129, 1, 0, 2, 0, 0, 123}, {2, 0, 1, 2, 0, 0, 2, 0, 0, 254},  {2, 0, 2, 0, 0, 0, 0, 254},
+// size of the buffer for bulk reads from UART
+static const uint8_t RX_CHUNK_SIZE = 32;
+// time to wait for the ACK of a packed write before falling back to single register writes
+static const uint32_t PACKED_WRITE_ACK_TIMEOUT = 1000;
+// longest time loop() leaves the command queue alone when no deadline is pending
+static const uint32_t QUEUE_MAX_IDLE = 1000;
+// max number of raw register reads waiting for their reply
+static const uint8_t RAW_READS_MAX = 8;
+// delay between setup of consecutive units on the same node
+static const uint32_t UNIT_SETUP_STAGGER = 1000;
+// reads sent without any reply after which the link is considered lost
+static const uint8_t LINK_MISSED_REPLIES = 5;
+static const uint32_t LINK_REPLY_TIMEOUT = 1000;
+// delay before reconnecting, doubled after each failed attempt
+static const uint32_t RECONNECT_DELAY_MIN = 1000;
+static const uint32_t RECONNECT_DELAY_MAX = 300000;
+// after a change made outside of this component (e.g. by IR remote), settings are re-read
+// BURST_POLLS times every BURST_POLL_INTERVAL
+static const uint8_t BURST_POLLS = 5;
+static const uint32_t BURST_POLL_INTERVAL = 2000;
+// learned registers change in bursts (handshake, scan), they are saved this long after the last change
+static const uint32_t CAPABILITIES_SAVE_DELAY = 10000;
+// change of indoor fan speed (IDU status) which starts the burst polling
+static const uint8_t FAN_RPM_JUMP = 10;
+#ifdef USE_TOSHIBA_SUZUMI_ENERGY
+// lifetime energy is written to flash at most once per interval (and on shutdown)
+static const uint32_t ENERGY_SAVE_INTERVAL = 900000;
+// energy refresh interval by demand: compressor running, unit on with unknown compressor state,
+// unit on with idle compressor, unit off or self-cleaning
+static const uint32_t ENERGY_SYNC_RUNNING = 30000;
+static const uint32_t ENERGY_SYNC_ON = 60000;
+static const uint32_t ENERGY_SYNC_IDLE = 300000;
+static const uint32_t ENERGY_SYNC_OFF = 1800000;
+// energy is also refreshed this long before each full hour (from the time source), so the consumption
+// of the last hour of the day is read before the unit rolls its day over at midnight
+static const uint32_t ENERGY_SYNC_HOUR_LEAD = 10000;
+// period of the check whether the energy refresh is due
+static const uint32_t ENERGY_SYNC_CHECK = 1000;
+
+/// Energy counters persisted in flash.
+struct ToshibaEnergyState {
+  uint32_t lifetime;   // Wh
+  uint16_t hours[24];  // daily consumption per hour from the last ENERGY_DAILY frame, Wh
+  uint8_t day;         // day of month of the hours, 0 when unknown
 };
+#endif
 
-static const std::vector<uint8_t> AFTER_HANDSHAKE[2] = {
-    {2, 0, 2, 1, 0, 0, 2, 0, 0, 251},
-    {2, 0, 2, 2, 0, 0, 2, 0, 0, 250},
+/**
+ * Writes of one control() call collected into a single frame. Only one packed write
+ * is in flight, it's kept outside the queue so queued commands stay small.
+ */
+struct ToshibaPackedWrite {
+  ToshibaCommandType regs[PACKED_WRITE_MAX];
+  uint8_t values[PACKED_WRITE_MAX];
+  uint8_t count;
+  bool awaiting_ack;
+  uint32_t sent_at;
 };
 
-struct ToshibaCommand {
-  ToshibaCommandType cmd;
-  std::vector<uint8_t> payload;
-  int delay;
+class ToshibaClimateUart;
+
+/**
+ * Node-wide registry of the Toshiba units handled by this node.
+ * Every unit gets a slot, the slots are used to spread the handshake and the periodic
+ * polls of all units evenly over time, so loop time stays flat with every extra unit.
+ */
+class ToshibaPollScheduler {
+ public:
+  /// Assign next free slot to the unit.
+  static uint8_t register_unit() { return unit_count_++; }
+  /// Number of units registered on this node.
+  static uint8_t unit_count() { return unit_count_; }
+  /// Delay of the unit's poll within the update interval.
+  static uint32_t poll_offset(uint8_t slot, uint32_t interval) { return interval / unit_count_ * slot; }
+
+ private:
+  static uint8_t unit_count_;
 };
 
 class ToshibaClimateUart : public PollingComponent, public climate::Climate, public uart::UARTDevice {
@@ -50,33 +122,126 @@ class ToshibaClimateUart : public PollingComponent, public climate::Climate, pub
   void dump_config() override;
   void update() override;
   void scan();
-  void set_wifi_led(bool enabled);
+  void set_wifi_led(bool enabled, bool force = false);
   float get_setup_priority() const override { return setup_priority::LATE; }
+#ifdef USE_TOSHIBA_SUZUMI_ENERGY
+  void on_shutdown() override;
+#endif
 
+#ifdef USE_TOSHIBA_SUZUMI_INDOOR_TEMP
   void set_indoor_temp_sensor(sensor::Sensor *indoor_temp_sensor) { indoor_temp_sensor_ = indoor_temp_sensor; }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_TEMP
   void set_outdoor_temp_sensor(sensor::Sensor *outdoor_temp_sensor) { outdoor_temp_sensor_ = outdoor_temp_sensor; }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_ODU_STATUS
   void set_cdu_td_temp_sensor(sensor::Sensor *sensor) { cdu_td_temp_sensor_ = sensor; }
   void set_cdu_ts_temp_sensor(sensor::Sensor *sensor) { cdu_ts_temp_sensor_ = sensor; }
   void set_cdu_te_temp_sensor(sensor::Sensor *sensor) { cdu_te_temp_sensor_ = sensor; }
   void set_cdu_load_sensor(sensor::Sensor *sensor) { cdu_load_sensor_ = sensor; }
   void set_cdu_iac_sensor(sensor::Sensor *sensor) { cdu_iac_sensor_ = sensor; }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_IDU_STATUS
   void set_fcu_tc_temp_sensor(sensor::Sensor *sensor) { fcu_tc_temp_sensor_ = sensor; }
   void set_fcu_tcj_temp_sensor(sensor::Sensor *sensor) { fcu_tcj_temp_sensor_ = sensor; }
   void set_fcu_fan_rpm_sensor(sensor::Sensor *sensor) { fcu_fan_rpm_sensor_ = sensor; }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_TIME_SYNC
   void set_time(time::RealTimeClock *time) { time_ = time; }
+  void set_time_sync_interval(uint32_t interval) { time_sync_interval_ = interval; }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_ENERGY
   void set_energy_sensor(sensor::Sensor *sensor) { energy_sensor_ = sensor; }
   void set_power_sensor(sensor::Sensor *sensor) { power_sensor_ = sensor; }
+  void set_lifetime_energy_sensor(sensor::Sensor *sensor) { lifetime_energy_sensor_ = sensor; }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_PWR_SELECT
   void set_pwr_select(select::Select *pws_select) { pwr_select_ = pws_select; }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_VERTICAL_AIR_DIRECTION
   void set_vertical_air_direction_select(select::Select *vertical_air_direction_select) {
     vertical_air_direction_select_ = vertical_air_direction_select;
   }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_SELF_CLEAN
   void set_self_clean_sensor(binary_sensor::BinarySensor *self_clean_sensor) { self_clean_sensor_ = self_clean_sensor; }
-  void set_horizontal_swing(bool enabled) { horizontal_swing_ = enabled; }
-  void disable_heat_mode(bool disabled) { heat_mode_disabled_ = disabled; }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_CONNECTED
+  void set_connected_sensor(binary_sensor::BinarySensor *sensor) { connected_sensor_ = sensor; }
+#endif
+  void set_horizontal_swing(bool enabled) {
+    horizontal_swing_ = enabled;
+    traits_built_ = false;
+  }
+  void disable_heat_mode(bool disabled) {
+    heat_mode_disabled_ = disabled;
+    traits_built_ = false;
+  }
   void disable_wifi_led(bool disabled) { wifi_led_disabled_ = disabled; }
-  void set_supported_presets(const std::vector<const char *> &presets) { supported_presets_ = presets; }
-  void set_min_temp(uint8_t min_temp) { min_temp_ = min_temp; }
-  void set_time_sync_interval(uint32_t interval) { time_sync_interval_ = interval; }
+  void set_supported_presets(const std::vector<const char *> &presets);
+  void set_min_temp(uint8_t min_temp) {
+    min_temp_ = min_temp;
+    traits_built_ = false;
+  }
+#ifdef USE_TOSHIBA_SUZUMI_LINK_STATS
+  void set_link_stats_sensor(LinkStat stat, sensor::Sensor *sensor) {
+    link_stats_sensors_[static_cast<uint8_t>(stat)] = sensor;
+  }
+  void set_link_stats_interval(uint32_t interval) { link_stats_interval_ = interval; }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_LATENCY_REPORT
+  void set_latency_report_interval(uint32_t interval) { latency_report_interval_ = interval; }
+#endif
+  void set_loop_budget(uint32_t budget_us) { loop_budget_us_ = budget_us; }
+  void set_packed_writes(bool enabled) { packed_writes_ = enabled; }
+  void set_force_writes(bool force) { force_writes_ = force; }
+#ifdef USE_TOSHIBA_SUZUMI_RX_TASK
+  void set_rx_task(bool enabled) { use_rx_task_ = enabled; }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_PROFILE
+  void set_profile_interval(uint32_t interval) { profile_interval_ = interval; }
+  const ToshibaProfiler &get_profiler() const { return profiler_; }
+#endif
+  const ToshibaLinkStats &get_link_stats() const { return link_stats_; }
+  bool is_link_lost() const { return link_lost_; }
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT
+  void set_outdoor_unit(ToshibaOutdoorUnit *outdoor_unit) {
+    // a full hub is rejected by the config validation, the unit would run standalone
+    if (outdoor_unit->register_unit(this)) {
+      outdoor_unit_ = outdoor_unit;
+    }
+  }
+#endif
+  const ToshibaCapabilities &get_capabilities() const { return capabilities_; }
+  /// Forget learned registers, all of them are polled again.
+  void reset_capabilities();
+  const ToshibaControlState &get_control_state() const { return control_state_; }
+#ifdef USE_TOSHIBA_SUZUMI_RAW_REGISTER
+  /// Read any register, also the ones not modelled by ToshibaCommandType. The reply is reported to the callbacks.
+  void read_register(uint8_t reg);
+  /// Write any register and read it back. The read back value is reported to the callbacks.
+  void write_register(uint8_t reg, uint8_t value);
+  void add_on_register_value_callback(std::function<void(uint8_t, uint8_t)> &&callback) {
+    this->register_value_callback_.add(std::move(callback));
+  }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_CAPTURE
+  /// Poll IDU/ODU status every interval for the duration and keep the samples in RAM instead of publishing them.
+  void start_capture(uint32_t duration, uint32_t interval);
+  void stop_capture();
+  /// Log the captured samples as CSV.
+  void export_capture();
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_REGISTER_TRIGGERS
+  /// Called with register and value of every accepted value report.
+  void add_on_register_callback(std::function<void(uint8_t, uint8_t)> &&callback) {
+    this->register_callback_.add(std::move(callback));
+  }
+  /// Called with register and raw data of every decoded frame.
+  void add_on_frame_callback(std::function<void(uint8_t, const uint8_t *, uint8_t)> &&callback) {
+    this->frame_callback_.add(std::move(callback));
+  }
+#endif
 
  protected:
   /// Override control to change settings of the climate device.
@@ -86,78 +251,286 @@ class ToshibaClimateUart : public PollingComponent, public climate::Climate, pub
   climate::ClimateTraits traits() override;
 
  private:
-  std::vector<uint8_t> rx_message_;
-  std::vector<ToshibaCommand> command_queue_;
-  uint32_t last_command_timestamp_ = 0;
-  uint32_t last_rx_char_timestamp_ = 0;
+  ToshibaLine line_;
+  // next register to request while scan is running, 0 when not scanning
+  uint16_t scan_register_ = 0;
+  // next time loop() runs the command queue, unless data is received earlier
+  uint32_t queue_wakeup_at_ = 0;
   STATE power_state_ = STATE::OFF;
   // True while the unit is running its post-shutdown self-cleaning cycle.
   bool self_clean_running_ = false;
   optional<SPECIAL_MODE> special_mode_ = SPECIAL_MODE::STANDARD;
+#ifdef USE_TOSHIBA_SUZUMI_PWR_SELECT
   select::Select *pwr_select_ = nullptr;
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_VERTICAL_AIR_DIRECTION
   select::Select *vertical_air_direction_select_ = nullptr;
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_SELF_CLEAN
   binary_sensor::BinarySensor *self_clean_sensor_ = nullptr;
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_INDOOR_TEMP
   sensor::Sensor *indoor_temp_sensor_ = nullptr;
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_TEMP
   sensor::Sensor *outdoor_temp_sensor_ = nullptr;
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_ODU_STATUS
   sensor::Sensor *cdu_td_temp_sensor_ = nullptr;
   sensor::Sensor *cdu_ts_temp_sensor_ = nullptr;
   sensor::Sensor *cdu_te_temp_sensor_ = nullptr;
   sensor::Sensor *cdu_load_sensor_ = nullptr;
   sensor::Sensor *cdu_iac_sensor_ = nullptr;
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_IDU_STATUS
   sensor::Sensor *fcu_tc_temp_sensor_ = nullptr;
   sensor::Sensor *fcu_tcj_temp_sensor_ = nullptr;
   sensor::Sensor *fcu_fan_rpm_sensor_ = nullptr;
-  time::RealTimeClock *time_ = nullptr;
-  sensor::Sensor *energy_sensor_ = nullptr;
-  sensor::Sensor *power_sensor_ = nullptr;
+#endif
   bool horizontal_swing_ = false;
   uint8_t min_temp_ = 17; // default min temp for units without 8° heating mode
   bool heat_mode_disabled_ = false;
   bool wifi_led_disabled_ = false;
-  std::vector<const char*> supported_presets_;
+  // last state written to the unit's Wi-Fi LED, unknown until written
+  optional<bool> wifi_led_;
+  // configured presets, bit N set when SPECIAL_MODE_TABLE[N] is supported
+  uint16_t supported_special_modes_ = 0;
+  bool is_special_mode_supported_(SPECIAL_MODE mode) const {
+    auto i = SPECIAL_MODE_TABLE.index_of(mode);
+    return i != SPECIAL_MODE_TABLE.NO_INDEX && (this->supported_special_modes_ & (1 << i));
+  }
+  // traits don't change after configuration, build them once on first use
+  climate::ClimateTraits traits_;
+  bool traits_built_ = false;
+  void build_traits_();
+#ifdef USE_TOSHIBA_SUZUMI_TIME_SYNC
+  time::RealTimeClock *time_ = nullptr;
   uint32_t last_time_sync_ = 0;
+  bool time_synced_ = false;
+  uint32_t time_sync_interval_{86400000};
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_ENERGY
+  sensor::Sensor *energy_sensor_ = nullptr;
+  sensor::Sensor *power_sensor_ = nullptr;
   uint32_t last_energy_sync_ = 0;
   uint32_t last_total_daily_energy_ = 0;
   uint32_t last_energy_update_ms_ = 0;
-  uint16_t daily_energy_usage_[24] = {0};
-  bool time_synced_ = false;
-  uint32_t time_sync_interval_{86400000};
+  sensor::Sensor *lifetime_energy_sensor_ = nullptr;
+  ToshibaEnergyState energy_state_{};
+  ESPPreferenceObject energy_pref_;
+  // energy_state_ holds hours of a received frame (or restored ones), deltas can be computed
+  bool energy_baseline_ = false;
+  bool energy_dirty_ = false;
+  uint32_t last_energy_save_ = 0;
+  // refresh interval by the last demand check
+  uint32_t energy_sync_interval_ = 0;
+  // from the ODU status, unknown until the unit pushes it
+  optional<bool> compressor_running_;
+#endif
+  uint8_t unit_slot_ = 0;
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT
+  ToshibaOutdoorUnit *outdoor_unit_ = nullptr;
+#endif
+  ToshibaLinkStats link_stats_;
+  ToshibaControlState control_state_;
+  ToshibaCapabilities capabilities_;
+  ESPPreferenceObject capabilities_pref_;
+  bool capabilities_dirty_ = false;
+  uint32_t capabilities_changed_at_ = 0;
+  ToshibaTransactions transactions_;
+  // write several settings changed by one control() call in one frame
+  bool packed_writes_ = false;
+  // the unit didn't acknowledge a packed write, registers are written one by one
+  bool packed_writes_rejected_ = false;
+  bool collecting_writes_ = false;
+  ToshibaPackedWrite packed_write_{};
+  // write settings even when the unit already holds the value
+  bool force_writes_ = false;
+#ifdef USE_TOSHIBA_SUZUMI_RAW_REGISTER
+  CallbackManager<void(uint8_t, uint8_t)> register_value_callback_;
+  // raw reads waiting for their reply, each is dropped when it's not answered within
+  // ToshibaTransactions::TIMEOUT after its READ frame was sent
+  struct RawRead {
+    uint8_t reg;
+    bool sent;
+    uint32_t sent_at;
+  };
+  RawRead raw_reads_[RAW_READS_MAX]{};
+  uint8_t raw_read_count_ = 0;
+  RawRead *find_raw_read_(uint8_t reg);
+  void remove_raw_read_(RawRead *read);
+  void raw_read_sent_(uint8_t reg, uint32_t now);
+  bool take_raw_request_(uint8_t reg);
+  bool has_raw_requests_() const { return this->raw_read_count_ != 0; }
+  optional<uint32_t> next_raw_read_deadline_() const;
+  void expire_raw_requests_(uint32_t now);
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_REGISTER_TRIGGERS
+  CallbackManager<void(uint8_t, uint8_t)> register_callback_;
+  CallbackManager<void(uint8_t, const uint8_t *, uint8_t)> frame_callback_;
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_LINK_STATS
+  sensor::Sensor *link_stats_sensors_[static_cast<uint8_t>(LinkStat::COUNT)] = {nullptr};
+  uint32_t link_stats_interval_{60000};
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_LATENCY_REPORT
+  // 0 when this unit doesn't log the report
+  uint32_t latency_report_interval_{0};
+#endif
+  // a command was sent and no valid frame was received since then
+  bool awaiting_reply_ = false;
+  uint32_t awaiting_reply_since_ = 0;
+#ifdef USE_TOSHIBA_SUZUMI_RX_TASK
+  // UART is drained by a separate task, loop() reads the received bytes from its ring
+  bool use_rx_task_ = false;
+  ToshibaRxTask rx_task_;
+  uint32_t rx_overflows_ = 0;
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_CAPTURE
+  ToshibaCapture capture_;
+  uint32_t capture_duration_ = 0;
+  void capture_tick_();
+  void capture_status_(ToshibaCommandType status, const uint8_t *data);
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_PROFILE
+  ToshibaProfiler profiler_;
+  uint32_t profile_interval_{60000};
+#endif
+  // max time spent processing received data in one loop() run, in microseconds
+  uint32_t loop_budget_us_{2000};
+  // link supervision: reads sent since the last valid frame
+  uint8_t unanswered_reads_ = 0;
+  bool link_lost_ = false;
+  uint32_t reconnect_delay_ = RECONNECT_DELAY_MIN;
+  // last reported values of the settings watched for outside changes, bit N of watched_known_ is set
+  // when BURST_REGISTERS[N] was reported
+  uint8_t watched_values_[5]{};
+  uint8_t watched_known_ = 0;
+  optional<uint8_t> last_fan_rpm_;
+  uint8_t burst_polls_left_ = 0;
+  uint32_t burst_polled_at_ = 0;
+  // staggered poll of this unit waiting for its slot in the update interval
+  bool poll_pending_ = false;
+  uint32_t poll_at_ = 0;
+#ifdef USE_TOSHIBA_SUZUMI_CONNECTED
+  binary_sensor::BinarySensor *connected_sensor_ = nullptr;
+#endif
 
-  void enqueue_command_(const ToshibaCommand &command);
-  void send_to_uart(const ToshibaCommand command);
+  /// Returns false when the queue is full and the command was dropped.
+  bool enqueue_command_(const ToshibaCommand &command);
+  void commands_enqueued_();
+  void send_to_uart(const ToshibaCommand &command);
+  void write_frame_(const uint8_t *data, uint8_t length);
   void start_handshake();
-  void parseResponse(std::vector<uint8_t> rawData);
-  void requestData(ToshibaCommandType cmd);
+  void connect_();
+  void on_link_reply_();
+  void on_link_lost_();
+  bool is_outdoor_follower_() const;
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_TEMP
+  bool reads_outdoor_temp_() const;
+  void publish_outdoor_temp_(int8_t value);
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_ODU_STATUS
+  void publish_odu_status_(const ToshibaOduStatus &status);
+#endif
+  void watch_register_(ToshibaCommandType reg, uint8_t value, bool requested);
+  void start_burst_poll_(const char *reason);
+  void burst_poll_();
+  void poll_();
+  /// Run polls, burst polls and saves which are due. These are deadlines checked by loop() rather than
+  /// scheduler timeouts, which allocate each time they are set.
+  void run_deadlines_(uint32_t now);
+  void parseResponse(const uint8_t *rawData, uint8_t length);
+  /// Request a register. Unless forced, registers learned as unsupported are skipped.
+  /// Returns false when the read was skipped (unsupported register) or dropped (full queue).
+  bool requestData(ToshibaCommandType cmd, bool force = false);
+  void save_capabilities_();
+  /// Read the register and call the handler with the reply, or the timeout handler when there is none
+  /// (right away when the read is not sent). Returns false when the transaction could not be started.
+  bool transact_(ToshibaCommandType reg, ToshibaReplyHandler on_reply, ToshibaTimeoutHandler on_timeout = nullptr);
+  void check_self_clean_then_mode_();
+  void on_mode_reread_needed_();
+#ifdef USE_TOSHIBA_SUZUMI_SELF_CLEAN
+  void on_self_clean_checked_(uint8_t value);
+  void on_self_clean_ended_(uint8_t power_state);
+#endif
   void process_command_queue_();
-  void sendCmd(ToshibaCommandType cmd, uint8_t value);
+  void run_command_queue_();
+  uint32_t queue_idle_time_(uint32_t now);
+  void sendCmd(ToshibaCommandType cmd, uint8_t value, bool force = false);
+  void begin_writes_();
+  void flush_writes_();
+  void send_packed_write_(const ToshibaCommand &command);
+  void on_packed_write_rejected_();
   void getInitData();
   void handle_rx_byte_(uint8_t c);
-  bool validate_message_();
+  size_t read_rx_chunk_(uint8_t *chunk);
+  bool rx_pending_();
+  void handle_frame_(ToshibaFramer::Status status);
   void set_self_clean_running_(bool running);
+#ifdef USE_TOSHIBA_SUZUMI_PWR_SELECT
   void on_set_pwr_level(const std::string &value);
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_VERTICAL_AIR_DIRECTION
   void on_set_vertical_air_direction(const std::string &value);
+#endif
   void publish_vertical_air_direction_(SWING swing_mode);
   void configure_supported_custom_modes_();
-#ifdef USE_TIME
+#ifdef USE_TOSHIBA_SUZUMI_TIME_SYNC
   void check_time_sync_(uint32_t now);
   void sync_time_();
+  void send_time_();
 #endif
+#ifdef USE_TOSHIBA_SUZUMI_ENERGY
   void sync_energy_();
+  uint32_t energy_demand_interval_() const;
+  void check_energy_sync_();
   void estimate_wattage_(uint32_t current_energy);
+  bool has_energy_sensors_() const {
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT
+    // the leader estimates power of the shared outdoor unit
+    if (this->outdoor_unit_ != nullptr && this->outdoor_unit_->has_power_sensor() &&
+        this->outdoor_unit_->is_leader(this)) {
+      return true;
+    }
+#endif
+    return this->energy_sensor_ != nullptr || this->power_sensor_ != nullptr || this->lifetime_energy_sensor_ != nullptr;
+  }
+  void publish_power_(float watts);
+  void update_lifetime_energy_(const uint16_t *hours);
+  void save_energy_state_();
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_LINK_STATS
+  bool has_link_stats_sensors_() const;
+  void publish_link_stats_();
+#else
+  bool has_link_stats_sensors_() const { return false; }
+#endif
+#ifdef USE_TOSHIBA_SUZUMI_LATENCY_REPORT
+  void log_latency_report_() const;
+#endif
+#if defined(USE_TOSHIBA_SUZUMI_LINK_STATS) || defined(USE_TOSHIBA_SUZUMI_LATENCY_REPORT)
+  void reset_latency_stats_();
+#endif
 
+  friend class ToshibaOutdoorUnit;
   friend class ToshibaPwrModeSelect;
   friend class ToshibaVerticalAirDirectionSelect;
 };
 
+#ifdef USE_TOSHIBA_SUZUMI_PWR_SELECT
 class ToshibaPwrModeSelect : public select::Select, public esphome::Parented<ToshibaClimateUart> {
  protected:
   virtual void control(const std::string &value) override;
 };
+#endif
 
+#ifdef USE_TOSHIBA_SUZUMI_VERTICAL_AIR_DIRECTION
 class ToshibaVerticalAirDirectionSelect : public select::Select, public esphome::Parented<ToshibaClimateUart> {
  protected:
   virtual void control(const std::string &value) override;
 };
+#endif
 
 }  // namespace toshiba_suzumi
 }  // namespace esphome
@@ -6,7 +6,7 @@
 namespace esphome {
 namespace toshiba_suzumi {
 
-const MODE ClimateModeToInt(climate::ClimateMode mode) {
+MODE ClimateModeToInt(climate::ClimateMode mode) {
   switch (mode) {
     case climate::CLIMATE_MODE_HEAT_COOL:
       return MODE::HEAT_COOL;
@@ -24,7 +24,7 @@ const MODE ClimateModeToInt(climate::ClimateMode mode) {
   }
 }
 
-const climate::ClimateMode IntToClimateMode(MODE mode) {
+climate::ClimateMode IntToClimateMode(MODE mode) {
   switch (mode) {
     case MODE::HEAT_COOL:
       return climate::CLIMATE_MODE_HEAT_COOL;
@@ -47,15 +47,7 @@ const climate::ClimateMode IntToClimateMode(MODE mode) {
  * @param mode The custom fan mode string to convert
  * @return The Toshiba fan mode code
  */
-const optional<FAN> StringToFanLevel(const char* mode) {
-  if (mode == CUSTOM_FAN_LEVEL_2) {
-    return FAN::FANMODE_2;
-  } else if (mode == CUSTOM_FAN_LEVEL_4) {
-    return FAN::FANMODE_4;
-  } else {
-    return nullopt;
-  }
-}
+const optional<FAN> StringToFanLevel(const char* mode) { return CUSTOM_FAN_MODE_TABLE.value(mode); }
 
 /**
  * Convert a Toshiba fan mode code to a custom fan mode string
@@ -63,65 +55,19 @@ const optional<FAN> StringToFanLevel(const char* mode) {
  * @return The custom fan mode string
  */
 const char* IntToCustomFanMode(FAN mode) {
-  switch (mode) {
-    case FAN::FANMODE_2:
-      return CUSTOM_FAN_LEVEL_2;
-    case FAN::FANMODE_4:
-      return CUSTOM_FAN_LEVEL_4;
-    default:
-      return "Unknown";
-  }
+  auto name = CUSTOM_FAN_MODE_TABLE.name(mode);
+  return name != nullptr ? name : "Unknown";
 }
 
-const optional<PWR_LEVEL> StringToPwrLevel(const std::string &mode) {
-  if (str_equals_case_insensitive(mode, CUSTOM_PWR_LEVEL_100)) {
-    return PWR_LEVEL::PCT_100;
-  } else if (str_equals_case_insensitive(mode, CUSTOM_PWR_LEVEL_75)) {
-    return PWR_LEVEL::PCT_75;
-  } else if (str_equals_case_insensitive(mode, CUSTOM_PWR_LEVEL_50)) {
-    return PWR_LEVEL::PCT_50;
-  } else {
-    return nullopt;
-  }
-}
+const optional<PWR_LEVEL> StringToPwrLevel(const char *mode) { return PWR_LEVEL_TABLE.value(mode); }
 
-const std::string IntToPowerLevel(PWR_LEVEL mode) {
-  switch (mode) {
-    case PWR_LEVEL::PCT_100:
-      return CUSTOM_PWR_LEVEL_100;
-    case PWR_LEVEL::PCT_75:
-      return CUSTOM_PWR_LEVEL_75;
-    case PWR_LEVEL::PCT_50:
-      return CUSTOM_PWR_LEVEL_50;
-    default:
-      return "Unknown";
-  }
+const char* IntToPowerLevel(PWR_LEVEL mode) {
+  auto name = PWR_LEVEL_TABLE.name(mode);
+  return name != nullptr ? name : "Unknown";
 }
 
-struct VerticalAirDirection {
-  SWING swing;
-  const char *name;
-};
-
-// Toshiba service manuals call the physical up/down flap a horizontal louver;
-// expose the user-facing effect as vertical air direction.
-static const VerticalAirDirection VERTICAL_AIR_DIRECTIONS[] = {
-    {SWING::OFF, "Off"},
-    {SWING::VERTICAL, "Swing"},
-    {SWING::VERTICAL_FIX_POSITION_1, "Top"},
-    {SWING::VERTICAL_FIX_POSITION_2, "Middle Top"},
-    {SWING::VERTICAL_FIX_POSITION_3, "Middle"},
-    {SWING::VERTICAL_FIX_POSITION_4, "Middle Bottom"},
-    {SWING::VERTICAL_FIX_POSITION_5, "Bottom"},
-};
-
-const optional<SWING> StringToVerticalAirDirection(const std::string &position) {
-  for (auto const &direction : VERTICAL_AIR_DIRECTIONS) {
-    if (str_equals_case_insensitive(position, direction.name)) {
-      return direction.swing;
-    }
-  }
-  return nullopt;
+const optional<SWING> StringToVerticalAirDirection(const char *position) {
+  return VERTICAL_AIR_DIRECTION_TABLE.value(position);
 }
 
 const char* SwingToVerticalAirDirection(SWING mode) {
@@ -131,12 +77,7 @@ const char* SwingToVerticalAirDirection(SWING mode) {
   if (mode == SWING::BOTH) {
     mode = SWING::VERTICAL;
   }
-  for (auto const &direction : VERTICAL_AIR_DIRECTIONS) {
-    if (mode == direction.swing) {
-      return direction.name;
-    }
-  }
-  return nullptr;
+  return VERTICAL_AIR_DIRECTION_TABLE.name(mode);
 }
 
 bool IsFixedVerticalAirDirection(SWING mode) {
@@ -145,7 +86,7 @@ bool IsFixedVerticalAirDirection(SWING mode) {
          value <= static_cast<uint8_t>(SWING::VERTICAL_FIX_POSITION_5);
 }
 
-const SWING ClimateSwingModeToInt(climate::ClimateSwingMode mode) {
+SWING ClimateSwingModeToInt(climate::ClimateSwingMode mode) {
   switch (mode) {
     case climate::CLIMATE_SWING_OFF:
       return SWING::OFF;
@@ -161,7 +102,7 @@ const SWING ClimateSwingModeToInt(climate::ClimateSwingMode mode) {
   }
 }
 
-const climate::ClimateSwingMode IntToClimateSwingMode(SWING mode) {
+climate::ClimateSwingMode IntToClimateSwingMode(SWING mode) {
   switch (mode) {
     case SWING::OFF:
       return climate::CLIMATE_SWING_OFF;
@@ -172,7 +113,7 @@ const climate::ClimateSwingMode IntToClimateSwingMode(SWING mode) {
     case SWING::BOTH:
       return climate::CLIMATE_SWING_BOTH;
     default:
-      ESP_LOGE(TAG, "Invalid swing mode %d.", mode);
+      ESP_LOGE(TAG, "Invalid swing mode %d.", static_cast<uint8_t>(mode));
       return climate::CLIMATE_SWING_OFF;
   }
 }
@@ -210,61 +151,11 @@ const LogString *climate_state_to_string(STATE mode) {
   }
 }
 
-const optional<SPECIAL_MODE> PresetToSpecialMode(const char* preset) {
-  if (str_equals_case_insensitive(preset, SPECIAL_MODE_STANDARD)) {
-    return SPECIAL_MODE::STANDARD;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_HI_POWER)) {
-    return SPECIAL_MODE::HI_POWER;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_ECO)) {
-    return SPECIAL_MODE::ECO;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_FIREPLACE_1)) {
-    return SPECIAL_MODE::FIREPLACE_1;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_FIREPLACE_2)) {
-    return SPECIAL_MODE::FIREPLACE_2;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_EIGHT_DEG)) {
-    return SPECIAL_MODE::EIGHT_DEG;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_SILENT_1)) {
-    return SPECIAL_MODE::SILENT_1;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_SILENT_2)) {
-    return SPECIAL_MODE::SILENT_2;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_SLEEP)) {
-    return SPECIAL_MODE::SLEEP;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_FLOOR)) {
-    return SPECIAL_MODE::FLOOR;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_COMFORT)) {
-    return SPECIAL_MODE::COMFORT;
-  } else {
-    return nullopt;
-  }
-}
+const optional<SPECIAL_MODE> PresetToSpecialMode(const char* preset) { return SPECIAL_MODE_TABLE.value(preset); }
 
 const char* SpecialModeToPreset(SPECIAL_MODE mode) {
-  switch (mode) {
-    case SPECIAL_MODE::STANDARD:
-      return SPECIAL_MODE_STANDARD;
-    case SPECIAL_MODE::HI_POWER:
-      return SPECIAL_MODE_HI_POWER;
-    case SPECIAL_MODE::ECO:
-      return SPECIAL_MODE_ECO;
-    case SPECIAL_MODE::FIREPLACE_1:
-      return SPECIAL_MODE_FIREPLACE_1;
-    case SPECIAL_MODE::FIREPLACE_2:
-      return SPECIAL_MODE_FIREPLACE_2;
-    case SPECIAL_MODE::EIGHT_DEG:
-      return SPECIAL_MODE_EIGHT_DEG;
-    case SPECIAL_MODE::SILENT_1:
-      return SPECIAL_MODE_SILENT_1;
-    case SPECIAL_MODE::SILENT_2:
-      return SPECIAL_MODE_SILENT_2;
-    case SPECIAL_MODE::SLEEP:
-      return SPECIAL_MODE_SLEEP;
-    case SPECIAL_MODE::FLOOR:
-      return SPECIAL_MODE_FLOOR;
-    case SPECIAL_MODE::COMFORT:
-      return SPECIAL_MODE_COMFORT;
-    default:
-      return SPECIAL_MODE_STANDARD;
-  }
+  auto name = SPECIAL_MODE_TABLE.name(mode);
+  return name != nullptr ? name : SPECIAL_MODE_STANDARD;
 }
 
 /**
@@ -273,58 +164,26 @@ const char* SpecialModeToPreset(SPECIAL_MODE mode) {
  * and we need to use a custom preset.
  */
 const optional<climate::ClimatePreset> StringToClimatePreset(const char *preset) {
-  if (str_equals_case_insensitive(preset, SPECIAL_MODE_STANDARD)) {
-    return climate::CLIMATE_PRESET_NONE;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_ECO)) {
-    return climate::CLIMATE_PRESET_ECO;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_HI_POWER)) {
-    return climate::CLIMATE_PRESET_BOOST;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_SLEEP)) {
-    return climate::CLIMATE_PRESET_SLEEP;
-  } else if (str_equals_case_insensitive(preset, SPECIAL_MODE_COMFORT)) {
-    return climate::CLIMATE_PRESET_COMFORT;
-  }
-  return nullopt;
+  return STANDARD_PRESET_TABLE.value(preset);
 }
 
 const char* ClimatePresetToString(climate::ClimatePreset preset) {
-  switch (preset) {
-    case climate::CLIMATE_PRESET_NONE:
-      return SPECIAL_MODE_STANDARD;
-    case climate::CLIMATE_PRESET_ECO:
-      return SPECIAL_MODE_ECO;
-    case climate::CLIMATE_PRESET_BOOST:
-      return SPECIAL_MODE_HI_POWER;
-    case climate::CLIMATE_PRESET_SLEEP:
-      return SPECIAL_MODE_SLEEP;
-    case climate::CLIMATE_PRESET_COMFORT:
-      return SPECIAL_MODE_COMFORT;
-    default:
-      return SPECIAL_MODE_STANDARD;
-  }
+  auto name = STANDARD_PRESET_TABLE.name(preset);
+  return name != nullptr ? name : SPECIAL_MODE_STANDARD;
 }
 
 const optional<SPECIAL_MODE> ClimatePresetToSpecialMode(climate::ClimatePreset preset) {
-  auto preset_string = ClimatePresetToString(preset);
-  return PresetToSpecialMode(preset_string);
+  auto name = STANDARD_PRESET_TABLE.name(preset);
+  return name != nullptr ? SPECIAL_MODE_TABLE.value(name) : SPECIAL_MODE::STANDARD;
 }
 
+/**
+ * Convert a special mode to the equivalent standard climate preset.
+ * Return nullopt for modes that are exposed as custom presets.
+ */
 const optional<climate::ClimatePreset> SpecialModeToClimatePreset(SPECIAL_MODE mode) {
-  switch (mode) {
-    case SPECIAL_MODE::STANDARD:
-      return climate::CLIMATE_PRESET_NONE;
-    case SPECIAL_MODE::ECO:
-      return climate::CLIMATE_PRESET_ECO;
-    case SPECIAL_MODE::HI_POWER:
-      return climate::CLIMATE_PRESET_BOOST;
-    case SPECIAL_MODE::SLEEP:
-      return climate::CLIMATE_PRESET_SLEEP;
-    case SPECIAL_MODE::COMFORT:
-      return climate::CLIMATE_PRESET_COMFORT;
-    default:
-      // For modes that don't have standard equivalents, return none
-      return nullopt;
-  }
+  auto name = SPECIAL_MODE_TABLE.name(mode);
+  return name != nullptr ? STANDARD_PRESET_TABLE.value(name) : nullopt;
 }
 
 }  // namespace toshiba_suzumi
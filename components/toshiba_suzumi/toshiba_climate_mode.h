@@ -1,8 +1,11 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <strings.h>
 #include "esphome/core/log.h"
 #include "esphome/components/climate/climate.h"
+#include "toshiba_protocol.h"
 
 namespace esphome {
 namespace toshiba_suzumi {
@@ -28,77 +31,116 @@ constexpr const char* SPECIAL_MODE_SLEEP = "Sleep";
 constexpr const char* SPECIAL_MODE_FLOOR = "Floor";
 constexpr const char* SPECIAL_MODE_COMFORT = "Comfort";
 
-// codes as reverse engineered from Toshiba AC communication with original Wifi module.
-enum class MODE { HEAT_COOL = 65, COOL = 66, HEAT = 67, DRY = 68, FAN_ONLY = 69 };
-enum class FAN {
-  FAN_QUIET = 49,
-  FAN_LOW = 50,
-  FANMODE_2 = 51,
-  FAN_MEDIUM = 52,
-  FANMODE_4 = 53,
-  FAN_HIGH = 54,
-  FAN_AUTO = 65
+/// Name of an enum value as exposed to Home Assistant (custom mode, select option or preset).
+template<typename E> struct EnumName {
+  E value;
+  const char *name;
 };
-enum class SWING {
-  OFF = 49,
-  BOTH = 67,
-  VERTICAL = 65,
-  HORIZONTAL = 66,
-  VERTICAL_FIX_POSITION_1 = 80,
-  VERTICAL_FIX_POSITION_2 = 81,
-  VERTICAL_FIX_POSITION_3 = 82,
-  VERTICAL_FIX_POSITION_4 = 83,
-  VERTICAL_FIX_POSITION_5 = 84
+
+/**
+ * Constant bidirectional mapping between enum values and their names.
+ * Values are found in O(1) through an index over the raw value range [FIRST, LAST] built at compile time.
+ * Names are found by a linear scan over the few entries. Options are registered with the constants above,
+ * so the pointer compare matches them; the case-insensitive compare is for strings coming from elsewhere.
+ */
+template<typename E, size_t N, uint8_t FIRST, uint8_t LAST> class EnumNameTable {
+ public:
+  static constexpr uint8_t NO_INDEX = 0xFF;
+
+  constexpr EnumNameTable(const EnumName<E> (&entries)[N]) : entries_{}, index_{} {
+    for (size_t i = 0; i <= LAST - FIRST; i++) {
+      this->index_[i] = NO_INDEX;
+    }
+    for (size_t i = 0; i < N; i++) {
+      this->entries_[i] = entries[i];
+      this->index_[static_cast<uint8_t>(entries[i].value) - FIRST] = i;
+    }
+  }
+
+  constexpr size_t size() const { return N; }
+  constexpr const EnumName<E> &operator[](size_t i) const { return this->entries_[i]; }
+
+  /// Position of the value in the table, NO_INDEX if the value is unknown.
+  constexpr uint8_t index_of(E value) const {
+    auto raw = static_cast<uint8_t>(value);
+    return raw < FIRST || raw > LAST ? NO_INDEX : this->index_[raw - FIRST];
+  }
+  /// Name of the value, nullptr if the value is unknown.
+  constexpr const char *name(E value) const {
+    auto i = this->index_of(value);
+    return i == NO_INDEX ? nullptr : this->entries_[i].name;
+  }
+  /// Value of the name, nullopt if the name is unknown.
+  optional<E> value(const char *name) const {
+    for (auto const &entry : this->entries_) {
+      if (entry.name == name || strcasecmp(entry.name, name) == 0)
+        return entry.value;
+    }
+    return nullopt;
+  }
+
+ private:
+  EnumName<E> entries_[N];
+  uint8_t index_[LAST - FIRST + 1];
 };
-enum class STATE { ON = 48, OFF = 49 };
-enum class PWR_LEVEL { PCT_50 = 50, PCT_75 = 75, PCT_100 = 100 };
-// Values documented by maxmacstn/ToshibaCarrierController.
-enum class SELF_CLEAN_STATE : uint8_t { RUNNING = 0x18, OFF = 0x10 };
-
-enum SPECIAL_MODE {
-  STANDARD = 0,
-  HI_POWER = 1,
-  ECO = 3,
-  FIREPLACE_1 = 32,
-  FIREPLACE_2 = 48,
-  EIGHT_DEG = 4,
-  SILENT_1 = 2,
-  SILENT_2 = 10,
-  SLEEP = 5,
-  FLOOR = 6,
-  COMFORT = 7
+
+constexpr EnumName<FAN> CUSTOM_FAN_MODES[] = {
+    {FAN::FANMODE_2, CUSTOM_FAN_LEVEL_2},
+    {FAN::FANMODE_4, CUSTOM_FAN_LEVEL_4},
 };
+constexpr EnumNameTable<FAN, 2, 51, 53> CUSTOM_FAN_MODE_TABLE{CUSTOM_FAN_MODES};
 
-enum class ToshibaCommandType : uint8_t {
-  HANDSHAKE = 0,  // dummy command to handle all handshake requests
-  DELAY = 1, // dummy command to issue a delay in communication
-  POWER_STATE = 128,
-  POWER_SEL = 135,
-  COMFORT_SLEEP = 148, // { ON = 65, OFF = 66 }
-  FAN = 160,
-  SWING = 163,
-  MODE = 176,
-  TARGET_TEMP = 179,
-  ROOM_TEMP = 187,
-  OUTDOOR_TEMP = 190,
-  WIFI_LED_1 = 222,
-  WIFI_LED_2 = 223,
-  SELF_CLEAN = 0xCB,
-  SPECIAL_MODE = 247,
-  ENERGY_DAILY = 0xD8,
-  ENERGY_WEEKLY = 0xD9,
-  ENERGY_MONTHLY = 0xDA,
-  ENERGY_YEARLY = 0xDB,
-  SET_DATE_TIME = 0xEA,
-  IDU_STATUS = 0xE4,   // 228 - Indoor unit status (unsolicited)
-  ODU_STATUS = 0xE5,   // 229 - Outdoor unit status (unsolicited)
+constexpr EnumName<PWR_LEVEL> PWR_LEVELS[] = {
+    {PWR_LEVEL::PCT_50, CUSTOM_PWR_LEVEL_50},
+    {PWR_LEVEL::PCT_75, CUSTOM_PWR_LEVEL_75},
+    {PWR_LEVEL::PCT_100, CUSTOM_PWR_LEVEL_100},
+};
+constexpr EnumNameTable<PWR_LEVEL, 3, 50, 100> PWR_LEVEL_TABLE{PWR_LEVELS};
+
+// Toshiba service manuals call the physical up/down flap a horizontal louver;
+// expose the user-facing effect as vertical air direction.
+constexpr EnumName<SWING> VERTICAL_AIR_DIRECTIONS[] = {
+    {SWING::OFF, "Off"},
+    {SWING::VERTICAL, "Swing"},
+    {SWING::VERTICAL_FIX_POSITION_1, "Top"},
+    {SWING::VERTICAL_FIX_POSITION_2, "Middle Top"},
+    {SWING::VERTICAL_FIX_POSITION_3, "Middle"},
+    {SWING::VERTICAL_FIX_POSITION_4, "Middle Bottom"},
+    {SWING::VERTICAL_FIX_POSITION_5, "Bottom"},
+};
+constexpr EnumNameTable<SWING, 7, 49, 84> VERTICAL_AIR_DIRECTION_TABLE{VERTICAL_AIR_DIRECTIONS};
+
+constexpr EnumName<SPECIAL_MODE> SPECIAL_MODES[] = {
+    {SPECIAL_MODE::STANDARD, SPECIAL_MODE_STANDARD},
+    {SPECIAL_MODE::HI_POWER, SPECIAL_MODE_HI_POWER},
+    {SPECIAL_MODE::ECO, SPECIAL_MODE_ECO},
+    {SPECIAL_MODE::FIREPLACE_1, SPECIAL_MODE_FIREPLACE_1},
+    {SPECIAL_MODE::FIREPLACE_2, SPECIAL_MODE_FIREPLACE_2},
+    {SPECIAL_MODE::EIGHT_DEG, SPECIAL_MODE_EIGHT_DEG},
+    {SPECIAL_MODE::SILENT_1, SPECIAL_MODE_SILENT_1},
+    {SPECIAL_MODE::SILENT_2, SPECIAL_MODE_SILENT_2},
+    {SPECIAL_MODE::SLEEP, SPECIAL_MODE_SLEEP},
+    {SPECIAL_MODE::FLOOR, SPECIAL_MODE_FLOOR},
+    {SPECIAL_MODE::COMFORT, SPECIAL_MODE_COMFORT},
+};
+constexpr EnumNameTable<SPECIAL_MODE, 11, 0, 48> SPECIAL_MODE_TABLE{SPECIAL_MODES};
+
+// Special modes which have an equivalent standard climate preset, the others are exposed as custom presets.
+// Named like the special mode, the name maps one to the other.
+constexpr EnumName<climate::ClimatePreset> STANDARD_PRESETS[] = {
+    {climate::CLIMATE_PRESET_NONE, SPECIAL_MODE_STANDARD},
+    {climate::CLIMATE_PRESET_ECO, SPECIAL_MODE_ECO},
+    {climate::CLIMATE_PRESET_BOOST, SPECIAL_MODE_HI_POWER},
+    {climate::CLIMATE_PRESET_SLEEP, SPECIAL_MODE_SLEEP},
+    {climate::CLIMATE_PRESET_COMFORT, SPECIAL_MODE_COMFORT},
 };
+constexpr EnumNameTable<climate::ClimatePreset, 5, 0, 7> STANDARD_PRESET_TABLE{STANDARD_PRESETS};
 
-const MODE ClimateModeToInt(climate::ClimateMode mode);
-const climate::ClimateMode IntToClimateMode(MODE mode);
+MODE ClimateModeToInt(climate::ClimateMode mode);
+climate::ClimateMode IntToClimateMode(MODE mode);
 
-const SWING ClimateSwingModeToInt(climate::ClimateSwingMode mode);
-const climate::ClimateSwingMode IntToClimateSwingMode(SWING mode);
+SWING ClimateSwingModeToInt(climate::ClimateSwingMode mode);
+climate::ClimateSwingMode IntToClimateSwingMode(SWING mode);
 
 const optional<FAN> ClimateFanModeToInt(climate::ClimateFanMode mode);
 
@@ -107,10 +149,10 @@ const LogString *climate_state_to_string(STATE mode);
 const optional<FAN> StringToFanLevel(const char* mode);
 const char* IntToCustomFanMode(FAN mode);
 
-const optional<PWR_LEVEL> StringToPwrLevel(const std::string &mode);
-const std::string IntToPowerLevel(PWR_LEVEL mode);
+const optional<PWR_LEVEL> StringToPwrLevel(const char *mode);
+const char* IntToPowerLevel(PWR_LEVEL mode);
 
-const optional<SWING> StringToVerticalAirDirection(const std::string &position);
+const optional<SWING> StringToVerticalAirDirection(const char *position);
 const char* SwingToVerticalAirDirection(SWING mode);
 bool IsFixedVerticalAirDirection(SWING mode);
 
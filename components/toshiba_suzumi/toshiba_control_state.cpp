@@ -0,0 +1,174 @@
+#include "toshiba_control_state.h"
+#include "toshiba_climate.h"
+#include "esphome/core/hal.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+ToshibaControlState::Field *ToshibaControlState::find_(ToshibaCommandType reg) {
+  for (auto &field : this->fields_) {
+    if (field.reg == reg) {
+      return &field;
+    }
+  }
+  return nullptr;
+}
+
+const ToshibaControlState::Field *ToshibaControlState::find_(ToshibaCommandType reg) const {
+  for (auto const &field : this->fields_) {
+    if (field.reg == reg) {
+      return &field;
+    }
+  }
+  return nullptr;
+}
+
+void ToshibaControlState::expect(ToshibaCommandType reg, uint8_t value) {
+  auto *field = this->find_(reg);
+  if (field == nullptr) {
+    return;
+  }
+  field->state = FieldState::PENDING;
+  field->expected = value;
+  field->sent = false;
+  field->requested_at = millis();
+}
+
+void ToshibaControlState::cancel(ToshibaCommandType reg) {
+  auto *field = this->find_(reg);
+  if (field != nullptr && field->state == FieldState::PENDING && !field->sent) {
+    field->state = FieldState::CONFIRMED;
+  }
+}
+
+void ToshibaControlState::confirm_(Field *field, uint8_t value) {
+  if (field->state == FieldState::PENDING && this->confirm_latency_ != nullptr) {
+    this->confirm_latency_->record(millis() - field->requested_at);
+  }
+  field->state = FieldState::CONFIRMED;
+  field->known = true;
+  field->held = value;
+}
+
+void ToshibaControlState::sent(ToshibaCommandType reg, uint32_t now) { this->sent_packed(&reg, 1, now); }
+
+void ToshibaControlState::sent_packed(const ToshibaCommandType *regs, uint8_t count, uint32_t now) {
+  uint8_t awaiting_ack = 0;
+  bool has_fields = false;
+  for (uint8_t i = 0; i < count; i++) {
+    auto *field = this->find_(regs[i]);
+    if (field == nullptr) {
+      continue;
+    }
+    has_fields = true;
+    if (field->state != FieldState::PENDING) {
+      continue;
+    }
+    field->sent = true;
+    field->deadline = now + CONFIRM_TIMEOUT;
+    awaiting_ack |= 1 << (field - this->fields_);
+  }
+  // writes of other registers (Wi-Fi LED, raw writes) leave the fields of the last field write waiting
+  if (has_fields) {
+    this->awaiting_ack_ = awaiting_ack;
+  }
+}
+
+void ToshibaControlState::acknowledged() {
+  for (uint8_t i = 0; i < sizeof(this->fields_) / sizeof(this->fields_[0]); i++) {
+    auto &field = this->fields_[i];
+    if ((this->awaiting_ack_ & (1 << i)) && field.state == FieldState::PENDING && field.sent) {
+      ESP_LOGV(TAG, "Register %d confirmed by ACK", static_cast<uint8_t>(field.reg));
+      this->confirm_(&field, field.expected);
+    }
+  }
+  this->awaiting_ack_ = 0;
+}
+
+bool ToshibaControlState::reported(ToshibaCommandType reg, uint8_t value) {
+  auto *field = this->find_(reg);
+  if (field == nullptr) {
+    return true;
+  }
+  switch (field->state) {
+    case FieldState::PENDING:
+      if (value != field->expected) {
+        ESP_LOGD(TAG, "Ignoring stale value %d of register %d, waiting for %d", value, static_cast<uint8_t>(reg),
+                 field->expected);
+        return false;
+      }
+      break;
+    case FieldState::DIVERGED:
+      if (value != field->expected) {
+        ESP_LOGW(TAG, "Unit did not apply value %d of register %d, keeping reported value %d", field->expected,
+                 static_cast<uint8_t>(reg), value);
+      }
+      break;
+    default:
+      break;
+  }
+  this->confirm_(field, value);
+  return true;
+}
+
+optional<ToshibaCommandType> ToshibaControlState::check_timeouts(uint32_t now) {
+  for (auto &field : this->fields_) {
+    if (field.state == FieldState::PENDING && field.sent && (int32_t) (now - field.deadline) >= 0) {
+      ESP_LOGD(TAG, "Register %d not confirmed in time, re-reading it", static_cast<uint8_t>(field.reg));
+      field.state = FieldState::DIVERGED;
+      return field.reg;
+    }
+  }
+  return nullopt;
+}
+
+optional<uint32_t> ToshibaControlState::next_deadline() const {
+  optional<uint32_t> deadline;
+  for (auto const &field : this->fields_) {
+    if (field.state == FieldState::PENDING && field.sent &&
+        (!deadline.has_value() || (int32_t) (field.deadline - *deadline) < 0)) {
+      deadline = field.deadline;
+    }
+  }
+  return deadline;
+}
+
+bool ToshibaControlState::holds(ToshibaCommandType reg, uint8_t value) const {
+  auto *field = this->find_(reg);
+  return field != nullptr && field->state == FieldState::CONFIRMED && field->known && field->held == value;
+}
+
+void ToshibaControlState::forget() {
+  for (auto &field : this->fields_) {
+    field.known = false;
+    field.state = FieldState::CONFIRMED;
+    field.sent = false;
+  }
+  this->awaiting_ack_ = 0;
+}
+
+FieldState ToshibaControlState::state(ToshibaCommandType reg) const {
+  auto *field = this->find_(reg);
+  return field == nullptr ? FieldState::CONFIRMED : field->state;
+}
+
+optional<uint8_t> ToshibaControlState::expected(ToshibaCommandType reg) const {
+  auto *field = this->find_(reg);
+  if (field == nullptr || field->state == FieldState::CONFIRMED) {
+    return nullopt;
+  }
+  return field->expected;
+}
+
+uint8_t ToshibaControlState::pending_count() const {
+  uint8_t count = 0;
+  for (auto const &field : this->fields_) {
+    if (field.state != FieldState::CONFIRMED) {
+      count++;
+    }
+  }
+  return count;
+}
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
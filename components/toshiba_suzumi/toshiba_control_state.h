@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include "toshiba_climate_mode.h"
+#include "toshiba_link_stats.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+enum class FieldState : uint8_t {
+  CONFIRMED = 0,  // reported values are accepted
+  PENDING,        // value was written, stale reports are ignored until the unit confirms it
+  DIVERGED,       // confirmation did not come in time, next reported value wins
+};
+
+/**
+ * Confirmation state of the settings written to the unit.
+ *
+ * control() shows requested values immediately. Until the unit confirms them, polls which
+ * still report the previous value are ignored, so the UI doesn't flicker back. When the
+ * confirmation doesn't come in time, the register is re-read and the unit's value is accepted.
+ */
+class ToshibaControlState {
+ public:
+  /// Time to wait for the confirmation after the write was sent to the unit.
+  static const uint16_t CONFIRM_TIMEOUT = 3000;
+
+  /// The value was requested, register is pending until it's confirmed.
+  void expect(ToshibaCommandType reg, uint8_t value);
+  /// The write was dropped before it was sent (full queue), accept the next reported value.
+  void cancel(ToshibaCommandType reg);
+  /// The write was sent to the unit, start waiting for the confirmation.
+  void sent(ToshibaCommandType reg, uint32_t now);
+  /// Several registers were written by one frame, one ACK confirms all of them.
+  void sent_packed(const ToshibaCommandType *regs, uint8_t count, uint32_t now);
+  /// The unit acknowledged the last write frame.
+  void acknowledged();
+  /// The unit reported a value of the register. Returns false when the value is stale and should be ignored.
+  bool reported(ToshibaCommandType reg, uint8_t value);
+  /// Mark the first pending register without confirmation as diverged and return it to be re-read.
+  optional<ToshibaCommandType> check_timeouts(uint32_t now);
+  /// Earliest confirmation deadline of the sent writes, if any.
+  optional<uint32_t> next_deadline() const;
+
+  /// Record time from the request to the confirmation of each setting.
+  void set_confirm_latency(LatencyHistogram *histogram) { this->confirm_latency_ = histogram; }
+
+  /// The unit is known to hold the value (reported or acknowledged) and no other value is pending.
+  bool holds(ToshibaCommandType reg, uint8_t value) const;
+  /// Forget values held by the unit and drop pending writes, sent or not, e.g. when the link was lost.
+  /// Reported values are accepted again.
+  void forget();
+
+  FieldState state(ToshibaCommandType reg) const;
+  optional<uint8_t> expected(ToshibaCommandType reg) const;
+  uint8_t pending_count() const;
+
+ protected:
+  struct Field {
+    ToshibaCommandType reg;
+    FieldState state{FieldState::CONFIRMED};
+    uint8_t expected{0};
+    bool sent{false};
+    uint32_t requested_at{0};
+    uint32_t deadline{0};
+    // last value reported or acknowledged by the unit
+    bool known{false};
+    uint8_t held{0};
+  };
+  void confirm_(Field *field, uint8_t value);
+  Field *find_(ToshibaCommandType reg);
+  const Field *find_(ToshibaCommandType reg) const;
+
+  // settings which can be changed by control() or selects
+  Field fields_[7] = {
+      {ToshibaCommandType::POWER_STATE}, {ToshibaCommandType::MODE},         {ToshibaCommandType::TARGET_TEMP},
+      {ToshibaCommandType::FAN},         {ToshibaCommandType::SWING},        {ToshibaCommandType::SPECIAL_MODE},
+      {ToshibaCommandType::POWER_SEL},
+  };
+  // fields written by the last write frame with any field, bit N for fields_[N], ACK frames don't carry
+  // the register
+  uint8_t awaiting_ack_ = 0;
+  LatencyHistogram *confirm_latency_ = nullptr;
+};
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
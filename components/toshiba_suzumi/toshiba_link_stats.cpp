@@ -0,0 +1,57 @@
+#include "toshiba_link_stats.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+static uint32_t bucket_lower_bound(uint8_t index) { return index == 0 ? 0 : 1UL << (index - 1); }
+static uint32_t bucket_upper_bound(uint8_t index) { return index == 0 ? 0 : (1UL << index) - 1; }
+
+void LatencyHistogram::record(uint32_t value_ms) {
+  uint8_t index = 0;
+  while (index < BUCKETS - 1 && value_ms >= (1UL << index)) {
+    index++;
+  }
+  if (this->buckets_[index] < UINT16_MAX) {
+    this->buckets_[index]++;
+  }
+  this->count_++;
+  if (value_ms > this->max_) {
+    this->max_ = value_ms;
+  }
+}
+
+uint32_t LatencyHistogram::percentile(uint8_t pct) const {
+  if (this->count_ == 0) {
+    return 0;
+  }
+  // rank of the requested sample, 1-based
+  uint32_t rank = (this->count_ * pct + 99) / 100;
+  if (rank == 0) {
+    rank = 1;
+  }
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < BUCKETS; i++) {
+    if (this->buckets_[i] == 0) {
+      continue;
+    }
+    if (seen + this->buckets_[i] >= rank) {
+      uint32_t lower = bucket_lower_bound(i);
+      uint32_t upper = (i == BUCKETS - 1) ? this->max_ : bucket_upper_bound(i);
+      uint32_t value = lower + (upper - lower) * (rank - seen) / this->buckets_[i];
+      return value < this->max_ ? value : this->max_;
+    }
+    seen += this->buckets_[i];
+  }
+  return this->max_;
+}
+
+void LatencyHistogram::reset() {
+  for (auto &bucket : this->buckets_) {
+    bucket = 0;
+  }
+  this->count_ = 0;
+  this->max_ = 0;
+}
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+/**
+ * Link statistics which can be published as sensors.
+ */
+enum class LinkStat : uint8_t {
+  FRAMES_SENT = 0,
+  FRAMES_RECEIVED,
+  CHECKSUM_ERRORS,
+  RX_TIMEOUTS,
+  UNKNOWN_FRAMES,
+  QUEUE_DEPTH,
+  QUEUE_HIGH_WATERMARK,
+  COMMAND_WAIT_P50,
+  COMMAND_WAIT_P95,
+  ROUND_TRIP_P50,
+  ROUND_TRIP_P95,
+  PEAK_LOOP_TIME,
+  RECONNECTS,
+  CONTROL_TO_WIRE_P50,
+  CONTROL_TO_WIRE_P99,
+  CONTROL_TO_CONFIRM_P50,
+  CONTROL_TO_CONFIRM_P99,
+  UNSOLICITED_FRAMES,
+  ELIDED_WRITES,
+  COUNT,  // number of statistics, keep last
+};
+
+/**
+ * Latency histogram with power-of-two millisecond buckets: 0, 1, 2-3, 4-7, ... ms.
+ * It's fixed size, so recording a value never allocates.
+ */
+class LatencyHistogram {
+ public:
+  static const uint8_t BUCKETS = 16;
+
+  void record(uint32_t value_ms);
+  /// Estimated value of the percentile (0-100) in ms, interpolated within the bucket. 0 when empty.
+  uint32_t percentile(uint8_t pct) const;
+  uint32_t count() const { return this->count_; }
+  uint32_t max() const { return this->max_; }
+  uint16_t bucket(uint8_t index) const { return this->buckets_[index]; }
+  void reset();
+
+ protected:
+  uint16_t buckets_[BUCKETS]{};
+  uint32_t count_ = 0;
+  uint32_t max_ = 0;
+};
+
+/**
+ * Counters and gauges describing quality of the UART link to the unit.
+ */
+struct ToshibaLinkStats {
+  uint32_t frames_sent = 0;
+  uint32_t frames_received = 0;
+  uint32_t checksum_errors = 0;
+  uint32_t rx_timeouts = 0;
+  uint32_t unknown_frames = 0;
+  // frames pushed by the unit, not replying to a read
+  uint32_t unsolicited_frames = 0;
+  // writes skipped because the unit already held the value
+  uint32_t elided_writes = 0;
+  uint16_t queue_high_watermark = 0;
+  // time commands spend in the queue before they are sent
+  LatencyHistogram command_wait;
+  // time from sending a command to receiving the next valid frame
+  LatencyHistogram round_trip;
+  // time from requesting a setting (control(), selects) to sending the write frame
+  LatencyHistogram control_to_wire;
+  // time from requesting a setting to its confirmation by the unit
+  LatencyHistogram control_to_confirm;
+  // longest loop() run in microseconds since the previous publish
+  uint32_t peak_loop_time = 0;
+  // loop() runs which left received data for the next run due to time budget
+  uint32_t loop_budget_exceeded = 0;
+  // handshakes repeated after the unit stopped replying
+  uint32_t reconnects = 0;
+};
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
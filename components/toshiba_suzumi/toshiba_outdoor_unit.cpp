@@ -0,0 +1,77 @@
+#include "esphome/core/defines.h"
+#include "toshiba_outdoor_unit.h"
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT
+#include "toshiba_climate.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+void ToshibaOutdoorUnit::dump_config() {
+  ESP_LOGCONFIG(TAG, "Toshiba outdoor unit, %u indoor units", this->unit_count_);
+  LOG_SENSOR("  ", "Load", this->load_sensor_);
+  LOG_SENSOR("  ", "Power", this->power_sensor_);
+}
+
+bool ToshibaOutdoorUnit::register_unit(ToshibaClimateUart *unit) {
+  if (this->unit_count_ == MAX_UNITS) {
+    ESP_LOGE(TAG, "Too many indoor units on one outdoor unit, max %u", MAX_UNITS);
+    return false;
+  }
+  this->units_[this->unit_count_++] = unit;
+  return true;
+}
+
+ToshibaClimateUart *ToshibaOutdoorUnit::leader() const {
+  for (uint8_t i = 0; i < this->unit_count_; i++) {
+    if (!this->units_[i]->is_link_lost()) {
+      return this->units_[i];
+    }
+  }
+  return this->unit_count_ == 0 ? nullptr : this->units_[0];
+}
+
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_TEMP
+bool ToshibaOutdoorUnit::needs_outdoor_temp() const {
+  for (uint8_t i = 0; i < this->unit_count_; i++) {
+    if (this->units_[i]->outdoor_temp_sensor_ != nullptr) {
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+void ToshibaOutdoorUnit::outdoor_temp_received(ToshibaClimateUart *from, int8_t value) {
+  if (!this->is_leader(from)) {
+    return;
+  }
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_TEMP
+  for (uint8_t i = 0; i < this->unit_count_; i++) {
+    this->units_[i]->publish_outdoor_temp_(value);
+  }
+#endif
+}
+
+void ToshibaOutdoorUnit::odu_status_received(ToshibaClimateUart *from, const ToshibaOduStatus &status) {
+  if (!this->is_leader(from)) {
+    return;
+  }
+  if (this->load_sensor_ != nullptr && status.has_load()) {
+    this->load_sensor_->publish_state(status.load_percent());
+  }
+#ifdef USE_TOSHIBA_SUZUMI_ODU_STATUS
+  for (uint8_t i = 0; i < this->unit_count_; i++) {
+    this->units_[i]->publish_odu_status_(status);
+  }
+#endif
+}
+
+void ToshibaOutdoorUnit::power_estimated(ToshibaClimateUart *from, float watts) {
+  if (this->power_sensor_ != nullptr && this->is_leader(from)) {
+    this->power_sensor_->publish_state(watts);
+  }
+}
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
+#endif
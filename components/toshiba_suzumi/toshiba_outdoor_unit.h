@@ -0,0 +1,58 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT
+#include <cstdint>
+#include "esphome/core/component.h"
+#include "esphome/components/sensor/sensor.h"
+#include "toshiba_protocol.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+class ToshibaClimateUart;
+
+/**
+ * Outdoor unit shared by several indoor units (multi-split).
+ *
+ * All indoor units report the same outdoor telemetry. Only the leader - the first registered
+ * unit with a working link - reads it, the other units skip these reads and receive the leader's
+ * values. Load and power of the outdoor unit are published once here instead of per indoor unit,
+ * where summing them would count the same consumption several times.
+ */
+class ToshibaOutdoorUnit : public Component {
+ public:
+  static const uint8_t MAX_UNITS = 8;
+
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::DATA; }
+
+  void set_load_sensor(sensor::Sensor *sensor) { load_sensor_ = sensor; }
+  void set_power_sensor(sensor::Sensor *sensor) { power_sensor_ = sensor; }
+  bool has_power_sensor() const { return this->power_sensor_ != nullptr; }
+
+  bool register_unit(ToshibaClimateUart *unit);
+  /// Unit which reads the shared telemetry, the first registered one when no unit is connected.
+  ToshibaClimateUart *leader() const;
+  bool is_leader(const ToshibaClimateUart *unit) const { return this->leader() == unit; }
+#ifdef USE_TOSHIBA_SUZUMI_OUTDOOR_TEMP
+  /// Any unit publishes the outdoor temperature, so the leader has to read it.
+  bool needs_outdoor_temp() const;
+#endif
+
+  /// Values received by a unit. Only the leader's are used, they are published by all units.
+  void outdoor_temp_received(ToshibaClimateUart *from, int8_t value);
+  void odu_status_received(ToshibaClimateUart *from, const ToshibaOduStatus &status);
+  void power_estimated(ToshibaClimateUart *from, float watts);
+
+ protected:
+  ToshibaClimateUart *units_[MAX_UNITS]{};
+  uint8_t unit_count_ = 0;
+  sensor::Sensor *load_sensor_ = nullptr;
+  sensor::Sensor *power_sensor_ = nullptr;
+};
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
+#endif
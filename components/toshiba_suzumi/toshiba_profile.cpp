@@ -0,0 +1,37 @@
+#include "esphome/core/defines.h"
+#include "toshiba_profile.h"
+#ifdef USE_TOSHIBA_SUZUMI_PROFILE
+#include <cinttypes>
+#include "toshiba_climate.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+static const char *const SECTION_NAMES[] = {
+    "loop", "handle_rx_byte", "validate_message", "parseResponse", "process_command_queue", "control", "publish",
+};
+
+void ToshibaProfiler::log(const char *header) const {
+  uint32_t per_us = ticks_per_us();
+  if (per_us == 0) {
+    per_us = 1;
+  }
+  ESP_LOGI(TAG, "%s (times in us: total / average / max)", header);
+  for (uint8_t i = 0; i < static_cast<uint8_t>(ProfileSection::COUNT); i++) {
+    auto &counter = this->counters_[i];
+    uint32_t total = counter.ticks / per_us;
+    uint32_t average = counter.calls == 0 ? 0 : counter.ticks / counter.calls / per_us;
+    ESP_LOGI(TAG, "  %-22s calls=%" PRIu32 " total=%" PRIu32 " avg=%" PRIu32 " max=%" PRIu32, SECTION_NAMES[i],
+             counter.calls, total, average, counter.max_ticks / per_us);
+  }
+}
+
+void ToshibaProfiler::reset() {
+  for (auto &counter : this->counters_) {
+    counter = Counter{};
+  }
+}
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
+#endif
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_TOSHIBA_SUZUMI_PROFILE
+#include <cstdint>
+#include "esphome/core/hal.h"
+#ifdef USE_HOST
+#include <chrono>
+#endif
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+/// Profiled functions. Times are inclusive, e.g. LOOP contains HANDLE_RX_BYTE which contains PARSE_RESPONSE.
+enum class ProfileSection : uint8_t {
+  LOOP = 0,
+  HANDLE_RX_BYTE,
+  VALIDATE_MESSAGE,
+  PARSE_RESPONSE,
+  PROCESS_COMMAND_QUEUE,
+  CONTROL,
+  PUBLISH,
+  COUNT,  // number of sections, keep last
+};
+
+/**
+ * Call counts and time spent in the hot functions. Time is measured in CPU cycles on the device
+ * and in nanoseconds of steady_clock on the host, both are converted to microseconds for the report.
+ */
+class ToshibaProfiler {
+ public:
+  struct Counter {
+    uint32_t calls;
+    uint64_t ticks;
+    uint32_t max_ticks;
+  };
+
+  static uint32_t now() {
+#ifdef USE_HOST
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#else
+    return arch_get_cpu_cycle_count();
+#endif
+  }
+  static uint32_t ticks_per_us() {
+#ifdef USE_HOST
+    return 1000;
+#else
+    return arch_get_cpu_freq_hz() / 1000000;
+#endif
+  }
+
+  void record(ProfileSection section, uint32_t ticks) {
+    auto &counter = this->counters_[static_cast<uint8_t>(section)];
+    counter.calls++;
+    counter.ticks += ticks;
+    if (ticks > counter.max_ticks) {
+      counter.max_ticks = ticks;
+    }
+  }
+  const Counter &counter(ProfileSection section) const { return this->counters_[static_cast<uint8_t>(section)]; }
+  /// Log calls, total, average and max time of each section.
+  void log(const char *header) const;
+  void reset();
+
+ protected:
+  Counter counters_[static_cast<uint8_t>(ProfileSection::COUNT)]{};
+};
+
+/// Records the time from construction to the end of the scope.
+class ToshibaProfileScope {
+ public:
+  ToshibaProfileScope(ToshibaProfiler &profiler, ProfileSection section)
+      : profiler_(profiler), section_(section), start_(ToshibaProfiler::now()) {}
+  ~ToshibaProfileScope() { this->profiler_.record(this->section_, ToshibaProfiler::now() - this->start_); }
+
+ protected:
+  ToshibaProfiler &profiler_;
+  ProfileSection section_;
+  uint32_t start_;
+};
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
+
+#define TOSHIBA_PROFILE(section) \
+  ToshibaProfileScope toshiba_profile_scope_(this->profiler_, ProfileSection::section)
+#else
+#define TOSHIBA_PROFILE(section)
+#endif
@@ -0,0 +1,251 @@
+#include <cstring>
+#include "toshiba_protocol.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+static const uint8_t HANDSHAKE_1[] = {2, 255, 255, 0, 0, 0, 0, 2};
+static const uint8_t HANDSHAKE_2[] = {2, 255, 255, 1, 0, 0, 1, 2, 254};
+static const uint8_t HANDSHAKE_3[] = {2, 0, 0, 0, 0, 0, 2, 2, 2, 250};
+static const uint8_t HANDSHAKE_4[] = {2, 0, 1, 129, 1, 0, 2, 0, 0, 123};
+static const uint8_t HANDSHAKE_5[] = {2, 0, 1, 2, 0, 0, 2, 0, 0, 254};
+static const uint8_t HANDSHAKE_6[] = {2, 0, 2, 0, 0, 0, 0, 254};
+static const uint8_t AFTER_HANDSHAKE_1[] = {2, 0, 2, 1, 0, 0, 2, 0, 0, 251};
+static const uint8_t AFTER_HANDSHAKE_2[] = {2, 0, 2, 2, 0, 0, 2, 0, 0, 250};
+
+const ToshibaFrame HANDSHAKE[] = {
+    {HANDSHAKE_1, sizeof(HANDSHAKE_1)}, {HANDSHAKE_2, sizeof(HANDSHAKE_2)}, {HANDSHAKE_3, sizeof(HANDSHAKE_3)},
+    {HANDSHAKE_4, sizeof(HANDSHAKE_4)}, {HANDSHAKE_5, sizeof(HANDSHAKE_5)}, {HANDSHAKE_6, sizeof(HANDSHAKE_6)},
+};
+const uint8_t HANDSHAKE_FRAMES = sizeof(HANDSHAKE) / sizeof(HANDSHAKE[0]);
+
+const ToshibaFrame AFTER_HANDSHAKE[] = {
+    {AFTER_HANDSHAKE_1, sizeof(AFTER_HANDSHAKE_1)},
+    {AFTER_HANDSHAKE_2, sizeof(AFTER_HANDSHAKE_2)},
+};
+const uint8_t AFTER_HANDSHAKE_FRAMES = sizeof(AFTER_HANDSHAKE) / sizeof(AFTER_HANDSHAKE[0]);
+
+// Prefix of frames reading and writing a register. Byte 6 (length) and 11 (data size) are filled in.
+static const uint8_t FRAME_PREFIX[] = {2, 0, 3, 16, 0, 0, 0, 1, 48, 1, 0, 0};
+static const uint8_t FRAME_PREFIX_LENGTH = sizeof(FRAME_PREFIX);
+
+uint8_t checksum(const uint8_t *data, uint8_t length) {
+  uint8_t sum = 0;
+  for (size_t i = 1; i < length; i++) {
+    sum += data[i];
+  }
+  return 256 - sum;
+}
+
+uint8_t build_read_frame(uint8_t *buffer, uint8_t reg) {
+  uint8_t length = FRAME_PREFIX_LENGTH;
+  memcpy(buffer, FRAME_PREFIX, FRAME_PREFIX_LENGTH);
+  buffer[6] = 6;
+  buffer[11] = 1;
+  buffer[length++] = reg;
+  buffer[length] = checksum(buffer, length);
+  return length + 1;
+}
+
+uint8_t build_write_frame(uint8_t *buffer, uint8_t reg, uint8_t value) {
+  return build_packed_write_frame(buffer, &reg, &value, 1);
+}
+
+/**
+ * Register/value pairs follow each other after the prefix, the length and data size bytes
+ * cover all of them. The unit confirms the whole frame with a single ACK.
+ */
+uint8_t build_packed_write_frame(uint8_t *buffer, const uint8_t *regs, const uint8_t *values, uint8_t count) {
+  uint8_t length = FRAME_PREFIX_LENGTH;
+  memcpy(buffer, FRAME_PREFIX, FRAME_PREFIX_LENGTH);
+  buffer[6] = 5 + 2 * count;
+  buffer[11] = 2 * count;
+  for (uint8_t i = 0; i < count; i++) {
+    buffer[length++] = regs[i];
+    buffer[length++] = values[i];
+  }
+  buffer[length] = checksum(buffer, length);
+  return length + 1;
+}
+
+ToshibaFramer::Status ToshibaFramer::feed(uint8_t byte) {
+  if (this->complete_) {
+    this->reset();
+  }
+  bool overflow = this->length_ == RX_BUFFER_SIZE;
+  if (overflow) {
+    this->length_ = 0;
+  }
+  this->data_[this->length_++] = byte;
+  Status status = this->check_();
+  if (status != PENDING) {
+    this->complete_ = true;
+  }
+  return overflow ? OVERFLOW : status;
+}
+
+/**
+ * Validate the frame after each byte. Since we know the format only of some messages (expected length),
+ * unknown messages are never complete, the caller drops them on receive timeout.
+ */
+ToshibaFramer::Status ToshibaFramer::check_() {
+  uint8_t at = this->length_ - 1;
+  auto *data = this->data_;
+
+  // Byte 0: HEADER (always 0x02)
+  if (at == 0)
+    return data[0] == 0x02 ? PENDING : DISCARDED;
+
+  // always get first three bytes
+  if (at < 2) {
+    return PENDING;
+  }
+
+  // Byte 3
+  if (data[2] != 0x03) {
+    // Normal commands starts with 0x02 0x00 0x03 and have length between 15-17 bytes.
+    // however there are some special unknown handshake commands which has non-standard replies.
+    // Since we don't know their format, we can't validate them.
+    return PENDING;
+  }
+
+  if (at <= 5) {
+    // no validation for these fields
+    return PENDING;
+  }
+
+  // Byte 7: LENGTH
+  uint16_t length = 6 + data[6] + 1;  // prefix + data + checksum
+
+  // wait until all data is read
+  if (at < length)
+    return PENDING;
+
+  // last byte: CHECKSUM
+  return data[at] == checksum(data, at) ? FRAME : CHECKSUM_ERROR;
+}
+
+ToshibaReply decode_reply(const uint8_t *data, uint8_t length) {
+  switch (length) {
+    case 15:  // response to requestData with the actual value of sensor/setting
+      return {ToshibaReplyKind::VALUE, data[12], data[13], 0};
+    case 16:  // probably ACK for issued command, SET_DATE_TIME ACK ends in 0x99 0x99
+      return {data[14] == 0x99 ? ToshibaReplyKind::TIME_SYNC_ACK : ToshibaReplyKind::ACK, 0, 0, 0};
+    case 17:  // response to requestData with the actual value of sensor/setting
+      return {ToshibaReplyKind::VALUE, data[14], data[15], 0};
+    case 69:
+    case 70:  // energy daily response
+      return {ToshibaReplyKind::ENERGY, data[14], 0, 0};
+    case 22:  // extended status message (e.g., ODU_STATUS / IDU_STATUS)
+      return {ToshibaReplyKind::STATUS, data[12], 0, 13};
+    case 24:  // extended status message (e.g., ODU_STATUS / IDU_STATUS)
+      return {ToshibaReplyKind::STATUS, data[14], 0, 15};
+    default:
+      return {ToshibaReplyKind::UNKNOWN, 0, 0, 0};
+  }
+}
+
+ToshibaIduStatus decode_idu_status(const uint8_t *data) {
+  return {static_cast<int8_t>(data[0]), static_cast<int8_t>(data[1]), data[2]};
+}
+
+ToshibaOduStatus decode_odu_status(const uint8_t *data) {
+  return {static_cast<int8_t>(data[0]), static_cast<int8_t>(data[1]), static_cast<int8_t>(data[2]), data[3], data[6]};
+}
+
+/**
+ * The hours follow from byte 21 of the frame as little endian uint16 values.
+ */
+uint32_t decode_energy_daily(const uint8_t *data, uint16_t *hours) {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < 24; i++) {
+    hours[i] = (data[21 + (i * 2) + 1] << 8) | data[21 + (i * 2)];
+    total += hours[i];
+  }
+  return total;
+}
+
+bool ToshibaLine::enqueue(const ToshibaCommand &command, uint32_t now) {
+  if (!this->queue_.push_back(command)) {
+    return false;
+  }
+  this->queue_.back().enqueued_at = now;
+  return true;
+}
+
+bool ToshibaLine::enqueue_handshake(uint32_t now) {
+  if (COMMAND_QUEUE_SIZE - this->queue_.size() < HANDSHAKE_FRAMES + 1 + AFTER_HANDSHAKE_FRAMES) {
+    return false;
+  }
+  for (uint8_t i = 0; i < HANDSHAKE_FRAMES; i++) {
+    this->enqueue_frame_(HANDSHAKE[i], now);
+  }
+  this->enqueue(
+      ToshibaCommand{.cmd = ToshibaCommandType::DELAY, .action = ToshibaCommandAction::DELAY, .delay = HANDSHAKE_DELAY},
+      now);
+  for (uint8_t i = 0; i < AFTER_HANDSHAKE_FRAMES; i++) {
+    this->enqueue_frame_(AFTER_HANDSHAKE[i], now);
+  }
+  return true;
+}
+
+void ToshibaLine::enqueue_frame_(const ToshibaFrame &frame, uint32_t now) {
+  this->enqueue(
+      ToshibaCommand{.cmd = ToshibaCommandType::HANDSHAKE, .action = ToshibaCommandAction::FRAME, .frame = &frame},
+      now);
+}
+
+ToshibaFramer::Status ToshibaLine::feed(uint8_t byte, uint32_t now) {
+  auto status = this->framer_.feed(byte);
+  if (this->framer_.pending()) {
+    this->last_rx_ = now;
+  }
+  return status;
+}
+
+bool ToshibaLine::expire_partial_frame(uint32_t now) {
+  if (now - this->last_rx_ > RECEIVE_TIMEOUT && this->framer_.pending()) {
+    this->framer_.reset();
+    return true;
+  }
+  return false;
+}
+
+bool ToshibaLine::take(uint32_t now, ToshibaCommand *command) {
+  uint32_t idle = now - this->last_sent_;
+  if (idle <= COMMAND_DELAY || this->queue_.empty() || this->framer_.pending()) {
+    return false;
+  }
+  auto &next = this->queue_.front();
+  if (next.action == ToshibaCommandAction::DELAY) {
+    // DELAY commands don't send anything, they are removed when they are over
+    if (idle >= next.delay) {
+      this->queue_.pop_front();
+    }
+    return false;
+  }
+  *command = next;
+  this->queue_.pop_front();
+  this->last_sent_ = now;
+  return true;
+}
+
+uint32_t ToshibaLine::idle_time(uint32_t now, uint32_t wait) const {
+  if (this->framer_.pending()) {
+    // nothing is sent until the frame is complete, which takes a received byte, or dropped
+    wait_until(wait, now, this->last_rx_ + RECEIVE_TIMEOUT + 1);
+    return wait;
+  }
+  if (!this->queue_.empty()) {
+    auto &next = this->queue_.front();
+    uint32_t delay = COMMAND_DELAY + 1;
+    if (next.action == ToshibaCommandAction::DELAY && next.delay > delay) {
+      delay = next.delay;
+    }
+    wait_until(wait, now, this->last_sent_ + delay);
+  }
+  return wait;
+}
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
@@ -0,0 +1,339 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * The unit's serial protocol: framing, checksum, frame layouts, the paced command queue and the
+ * decoding of the registers. Deliberately free of ESPHome includes, so the protocol can be reused
+ * by tools talking to units over other transports (see tools/toshiba_daemon.cpp).
+ */
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+// max length of a received frame, longer frames are dropped
+static const uint8_t RX_BUFFER_SIZE = 128;
+// max number of registers written by one packed write frame
+static const uint8_t PACKED_WRITE_MAX = 6;
+// max length of a frame built for sending (except time sync which is written in parts):
+// prefix, register/value pairs of a packed write and checksum
+static const uint8_t TX_BUFFER_SIZE = 12 + 2 * PACKED_WRITE_MAX + 1;
+// a partially received frame is dropped when no byte follows for this long
+static const uint32_t RECEIVE_TIMEOUT = 200;
+// min time between two frames sent to the unit
+static const uint32_t COMMAND_DELAY = 100;
+// max number of commands waiting in the queue
+static const uint8_t COMMAND_QUEUE_SIZE = 40;
+// pause the unit needs between the handshake and the frames which follow it
+static const uint16_t HANDSHAKE_DELAY = 2000;
+// target temperature is shifted by this offset while the 8 degrees special mode is active
+static const uint8_t SPECIAL_TEMP_OFFSET = 16;
+// reported instead of a temperature the unit can't measure
+static const int8_t TEMP_UNKNOWN = 127;
+// compressor load and current from this value up are not known
+static const uint8_t ODU_VALUE_UNKNOWN = 254;
+
+// codes as reverse engineered from Toshiba AC communication with original Wifi module.
+enum class MODE { HEAT_COOL = 65, COOL = 66, HEAT = 67, DRY = 68, FAN_ONLY = 69 };
+enum class FAN {
+  FAN_QUIET = 49,
+  FAN_LOW = 50,
+  FANMODE_2 = 51,
+  FAN_MEDIUM = 52,
+  FANMODE_4 = 53,
+  FAN_HIGH = 54,
+  FAN_AUTO = 65
+};
+enum class SWING {
+  OFF = 49,
+  BOTH = 67,
+  VERTICAL = 65,
+  HORIZONTAL = 66,
+  VERTICAL_FIX_POSITION_1 = 80,
+  VERTICAL_FIX_POSITION_2 = 81,
+  VERTICAL_FIX_POSITION_3 = 82,
+  VERTICAL_FIX_POSITION_4 = 83,
+  VERTICAL_FIX_POSITION_5 = 84
+};
+enum class STATE { ON = 48, OFF = 49 };
+enum class PWR_LEVEL { PCT_50 = 50, PCT_75 = 75, PCT_100 = 100 };
+// Values documented by maxmacstn/ToshibaCarrierController.
+enum class SELF_CLEAN_STATE : uint8_t { RUNNING = 0x18, OFF = 0x10 };
+
+enum SPECIAL_MODE {
+  STANDARD = 0,
+  HI_POWER = 1,
+  ECO = 3,
+  FIREPLACE_1 = 32,
+  FIREPLACE_2 = 48,
+  EIGHT_DEG = 4,
+  SILENT_1 = 2,
+  SILENT_2 = 10,
+  SLEEP = 5,
+  FLOOR = 6,
+  COMFORT = 7
+};
+
+enum class ToshibaCommandType : uint8_t {
+  HANDSHAKE = 0,  // dummy command to handle all handshake requests
+  DELAY = 1, // dummy command to issue a delay in communication
+  POWER_STATE = 128,
+  POWER_SEL = 135,
+  COMFORT_SLEEP = 148, // { ON = 65, OFF = 66 }
+  FAN = 160,
+  SWING = 163,
+  MODE = 176,
+  TARGET_TEMP = 179,
+  ROOM_TEMP = 187,
+  OUTDOOR_TEMP = 190,
+  WIFI_LED_1 = 222,
+  WIFI_LED_2 = 223,
+  SELF_CLEAN = 0xCB,
+  SPECIAL_MODE = 247,
+  ENERGY_DAILY = 0xD8,
+  ENERGY_WEEKLY = 0xD9,
+  ENERGY_MONTHLY = 0xDA,
+  ENERGY_YEARLY = 0xDB,
+  SET_DATE_TIME = 0xEA,
+  IDU_STATUS = 0xE4,   // 228 - Indoor unit status (unsolicited)
+  ODU_STATUS = 0xE5,   // 229 - Outdoor unit status (unsolicited)
+};
+
+
+/**
+ * Reference to a constant frame stored in flash. The handshake frames are shared
+ * by all units on the node instead of each instance holding its own copy.
+ */
+struct ToshibaFrame {
+  const uint8_t *data;
+  uint8_t length;
+};
+
+extern const ToshibaFrame HANDSHAKE[];
+extern const uint8_t HANDSHAKE_FRAMES;
+extern const ToshibaFrame AFTER_HANDSHAKE[];
+extern const uint8_t AFTER_HANDSHAKE_FRAMES;
+
+/**
+ * Checksum is calculated from all bytes excluding start byte.
+ * It's (256 - (sum % 256)).
+ */
+uint8_t checksum(const uint8_t *data, uint8_t length);
+
+/// Build the frame reading the register into buffer of TX_BUFFER_SIZE. Returns the frame length.
+uint8_t build_read_frame(uint8_t *buffer, uint8_t reg);
+/// Build the frame writing the value to the register. Returns the frame length.
+uint8_t build_write_frame(uint8_t *buffer, uint8_t reg, uint8_t value);
+/// Build the frame writing count (at most PACKED_WRITE_MAX) registers at once. Returns the frame length.
+uint8_t build_packed_write_frame(uint8_t *buffer, const uint8_t *regs, const uint8_t *values, uint8_t count);
+
+/**
+ * Splits received bytes into frames. A complete frame (or the bytes dropped with it) stays
+ * readable through data() and length() until the next byte is fed.
+ */
+class ToshibaFramer {
+ public:
+  enum Status : uint8_t {
+    PENDING,         // byte stored, the frame is not complete yet
+    DISCARDED,       // byte doesn't start a frame
+    OVERFLOW,        // frame didn't fit into the buffer and was dropped, the byte starts a new one
+    CHECKSUM_ERROR,  // frame is complete, but its checksum doesn't match
+    FRAME,           // valid frame received
+  };
+
+  Status feed(uint8_t byte);
+  /// Drop the partially received frame.
+  void reset() {
+    this->length_ = 0;
+    this->complete_ = false;
+  }
+  /// A frame is being received.
+  bool pending() const { return this->length_ != 0 && !this->complete_; }
+  const uint8_t *data() const { return this->data_; }
+  uint8_t length() const { return this->length_; }
+
+ protected:
+  Status check_();
+
+  uint8_t data_[RX_BUFFER_SIZE];
+  uint8_t length_ = 0;
+  // the buffer holds an ended frame, the next byte starts a new one
+  bool complete_ = false;
+};
+
+enum class ToshibaReplyKind : uint8_t {
+  VALUE,          // value of a register, reply to a read or pushed by the unit
+  ACK,            // acknowledge of a write
+  TIME_SYNC_ACK,  // acknowledge of the time synchronization
+  STATUS,         // IDU/ODU status block
+  ENERGY,         // daily energy consumption
+  UNKNOWN,
+};
+
+/// Content of a received frame. Layout depends on the frame length only.
+struct ToshibaReply {
+  ToshibaReplyKind kind;
+  uint8_t reg;
+  uint8_t value;
+  // start of the data of STATUS frames
+  uint8_t data_offset;
+};
+
+ToshibaReply decode_reply(const uint8_t *data, uint8_t length);
+
+/// Indoor unit status (IDU_STATUS), decoded from the data of the status frame.
+struct ToshibaIduStatus {
+  int8_t tc;        // heat exchanger temperature, °C, TEMP_UNKNOWN when not measured
+  int8_t tcj;       // heat exchanger junction temperature, °C, TEMP_UNKNOWN when not measured
+  uint8_t fan_rpm;  // indoor fan speed, raw
+};
+
+/// Outdoor unit status (ODU_STATUS), decoded from the data of the status frame.
+struct ToshibaOduStatus {
+  int8_t td;     // compressor discharge temperature, °C, TEMP_UNKNOWN when not measured
+  int8_t ts;     // compressor suction temperature, °C, TEMP_UNKNOWN when not measured
+  int8_t te;     // outdoor heat exchanger temperature, °C, TEMP_UNKNOWN when not measured
+  uint8_t load;  // compressor load, raw, ODU_VALUE_UNKNOWN and above when not known
+  uint8_t iac;   // compressor current, A, ODU_VALUE_UNKNOWN and above when not known
+
+  bool has_load() const { return this->load < ODU_VALUE_UNKNOWN; }
+  /// Compressor load in percent.
+  float load_percent() const { return this->load / 1.7f; }
+  bool has_iac() const { return this->iac < ODU_VALUE_UNKNOWN; }
+  /// The compressor runs at some load or draws current.
+  bool compressor_running() const {
+    return (this->load > 0 && this->has_load()) || (this->iac > 0 && this->has_iac());
+  }
+};
+
+/// Decode the status block, data starts at ToshibaReply::data_offset of the frame.
+ToshibaIduStatus decode_idu_status(const uint8_t *data);
+ToshibaOduStatus decode_odu_status(const uint8_t *data);
+/// Hourly consumption of the unit's current day from an ENERGY_DAILY frame into hours[24], in Wh.
+/// Returns the consumption of the day.
+uint32_t decode_energy_daily(const uint8_t *data, uint16_t *hours);
+/// Target temperature of the TARGET_TEMP register, the unit holds it shifted in the 8 degrees special mode.
+inline uint8_t decode_target_temp(uint8_t value, bool eight_deg) {
+  return eight_deg ? value - SPECIAL_TEMP_OFFSET : value;
+}
+inline uint8_t encode_target_temp(uint8_t temp, bool eight_deg) {
+  return eight_deg ? temp + SPECIAL_TEMP_OFFSET : temp;
+}
+
+enum class ToshibaCommandAction : uint8_t {
+  FRAME,         // send constant frame (handshake)
+  DELAY,         // pause communication, nothing is sent
+  READ,          // request value of the register
+  WRITE,         // write value to the register
+  WRITE_PACKED,  // write values of several registers in one frame, built by the sender
+  TIME_SYNC,     // send current date and time, built by the sender
+};
+
+/**
+ * Queued command. The frame is built only when the command is sent, so the command
+ * is small, trivially copyable and queuing it never allocates.
+ */
+struct ToshibaCommand {
+  ToshibaCommandType cmd;
+  ToshibaCommandAction action;
+  uint8_t value{0};
+  uint16_t delay{0};
+  uint32_t enqueued_at{0};
+  const ToshibaFrame *frame{nullptr};
+};
+
+/**
+ * Fixed capacity FIFO queue. Storage is part of the object, push and pop never allocate.
+ */
+template<typename T, uint8_t N> class StaticQueue {
+ public:
+  bool empty() const { return this->size_ == 0; }
+  bool full() const { return this->size_ == N; }
+  uint8_t size() const { return this->size_; }
+  T &front() { return this->items_[this->head_]; }
+  const T &front() const { return this->items_[this->head_]; }
+  T &back() { return this->items_[(this->head_ + this->size_ - 1) % N]; }
+  bool push_back(const T &item) {
+    if (this->full()) {
+      return false;
+    }
+    this->items_[(this->head_ + this->size_) % N] = item;
+    this->size_++;
+    return true;
+  }
+  void pop_front() {
+    if (this->empty()) {
+      return;
+    }
+    this->head_ = (this->head_ + 1) % N;
+    this->size_--;
+  }
+  void clear() {
+    this->head_ = 0;
+    this->size_ = 0;
+  }
+
+ protected:
+  T items_[N];
+  uint8_t head_ = 0;
+  uint8_t size_ = 0;
+};
+
+/// Shorten wait to the time left until the deadline, 0 when it has passed.
+inline void wait_until(uint32_t &wait, uint32_t now, uint32_t deadline) {
+  int32_t left = deadline - now;
+  if (left < 0) {
+    left = 0;
+  }
+  if (static_cast<uint32_t>(left) < wait) {
+    wait = left;
+  }
+}
+
+/**
+ * Half-duplex line to one unit: received bytes go through the framer, queued commands are
+ * sent COMMAND_DELAY apart and never while a frame is being received. The caller owns the
+ * transport and the clock, times are milliseconds of any clock which wraps at 32 bits.
+ */
+class ToshibaLine {
+ public:
+  /// Queue the command, stamped with the time. Returns false when the queue is full and the command was dropped.
+  bool enqueue(const ToshibaCommand &command, uint32_t now);
+  /// Queue the handshake frames, HANDSHAKE_DELAY and the frames which follow it. Returns false when
+  /// the queue has no room for all of them, nothing is queued then.
+  bool enqueue_handshake(uint32_t now);
+  /// Feed a received byte, see ToshibaFramer.
+  ToshibaFramer::Status feed(uint8_t byte, uint32_t now);
+  /// Drop the partially received frame when no byte came for RECEIVE_TIMEOUT. Since the format of
+  /// some frames is unknown, they are never complete. Returns true when a frame was dropped.
+  bool expire_partial_frame(uint32_t now);
+  /**
+   * Take the next command to send. Nothing is taken before COMMAND_DELAY passed since the last
+   * command, while a frame is being received or a DELAY is running. A finished DELAY is removed
+   * and takes the turn. The taken command is sent at now, the caller builds and writes its frame.
+   */
+  bool take(uint32_t now, ToshibaCommand *command);
+  /// Time until take() or expire_partial_frame() may have something to do without a received byte, at most wait.
+  uint32_t idle_time(uint32_t now, uint32_t wait) const;
+  /// Drop the queued commands and the partially received frame.
+  void reset() {
+    this->queue_.clear();
+    this->framer_.reset();
+  }
+
+  const ToshibaFramer &framer() const { return this->framer_; }
+  uint8_t queue_size() const { return this->queue_.size(); }
+  /// Time the last command was taken.
+  uint32_t last_sent() const { return this->last_sent_; }
+
+ protected:
+  void enqueue_frame_(const ToshibaFrame &frame, uint32_t now);
+
+  ToshibaFramer framer_;
+  StaticQueue<ToshibaCommand, COMMAND_QUEUE_SIZE> queue_;
+  uint32_t last_sent_ = 0;
+  uint32_t last_rx_ = 0;
+};
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
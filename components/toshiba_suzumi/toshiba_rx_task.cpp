@@ -0,0 +1,64 @@
+#include "esphome/core/defines.h"
+#include "toshiba_rx_task.h"
+#ifdef USE_TOSHIBA_SUZUMI_RX_TASK
+#include "toshiba_climate.h"
+#ifdef USE_HOST
+#include <chrono>
+#endif
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+bool ToshibaRxTask::start(uart::UARTDevice *uart) {
+  this->uart_ = uart;
+#ifdef USE_ESP32
+  // above the main loop task, so reception isn't delayed by other components
+  if (xTaskCreate(&ToshibaRxTask::run_, "toshiba_rx", 2048, this, 2, &this->handle_) != pdPASS) {
+    this->uart_ = nullptr;
+  }
+#elif defined(USE_HOST)
+  this->thread_ = std::thread(&ToshibaRxTask::run_, this);
+  this->thread_.detach();
+#else
+  this->uart_ = nullptr;
+#endif
+  if (this->uart_ == nullptr) {
+    ESP_LOGE(TAG, "Failed to start UART RX task, reading UART in the main loop");
+    return false;
+  }
+  return true;
+}
+
+void ToshibaRxTask::run_(void *arg) {
+  auto *task = static_cast<ToshibaRxTask *>(arg);
+  while (true) {
+    task->drain_();
+#ifdef USE_ESP32
+    // with the default 100 Hz tick rate the interval rounds down to 0 ticks,
+    // the task would spin above the loop task and starve it
+    TickType_t ticks = pdMS_TO_TICKS(POLL_INTERVAL_MS);
+    vTaskDelay(ticks == 0 ? 1 : ticks);
+#elif defined(USE_HOST)
+    std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+#endif
+  }
+}
+
+void ToshibaRxTask::drain_() {
+  uint8_t chunk[RX_CHUNK_SIZE];
+  int available;
+  while ((available = this->uart_->available()) > 0) {
+    size_t length = available < RX_CHUNK_SIZE ? available : RX_CHUNK_SIZE;
+    if (!this->uart_->read_array(chunk, length)) {
+      return;
+    }
+    uint16_t stored = this->ring_.push(chunk, length);
+    if (stored < length) {
+      this->overflows_.fetch_add(length - stored, std::memory_order_relaxed);
+    }
+  }
+}
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
+#endif
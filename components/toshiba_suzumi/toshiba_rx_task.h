@@ -0,0 +1,56 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_TOSHIBA_SUZUMI_RX_TASK
+#include <atomic>
+#include <cstdint>
+#include "esphome/components/uart/uart.h"
+#include "toshiba_spsc_ring.h"
+#ifdef USE_ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif defined(USE_HOST)
+#include <thread>
+#endif
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+/**
+ * Task draining the UART independently of the main loop, so a slow component elsewhere
+ * on the node doesn't delay reception or overflow the UART RX FIFO. Received bytes are
+ * handed to loop() through the ring, framing and parsing stay in the main loop.
+ * On the host platform a std::thread takes the place of the FreeRTOS task.
+ */
+class ToshibaRxTask {
+ public:
+  static const uint16_t RING_SIZE = 512;
+  // the UART is polled this often (at least once per FreeRTOS tick), the RX FIFO holds much more
+  // data than arrives meanwhile
+  static const uint32_t POLL_INTERVAL_MS = 2;
+
+  bool start(uart::UARTDevice *uart);
+  bool is_running() const { return this->uart_ != nullptr; }
+  uint16_t read(uint8_t *data, uint16_t max) { return this->ring_.pop(data, max); }
+  uint16_t available() const { return this->ring_.size(); }
+  /// Bytes dropped because the main loop didn't empty the ring in time.
+  uint32_t overflows() const { return this->overflows_.load(std::memory_order_relaxed); }
+
+ protected:
+  static void run_(void *arg);
+  void drain_();
+
+  uart::UARTDevice *uart_ = nullptr;
+  SpscRing<RING_SIZE> ring_;
+  std::atomic<uint32_t> overflows_{0};
+#ifdef USE_ESP32
+  TaskHandle_t handle_ = nullptr;
+#elif defined(USE_HOST)
+  std::thread thread_;
+#endif
+};
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Ring handing received bytes from the RX task to the main loop. Free of ESPHome includes,
+ * so the handoff can be stress-tested on the host (tools/toshiba_ring_stress.cpp).
+ */
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+/**
+ * Lock-free single-producer/single-consumer byte ring. One thread only pushes, the other only pops;
+ * each side owns one index and publishes it with release ordering, so no lock is needed.
+ * Indexes run freely and wrap at 2^16, which is a multiple of the power-of-two size.
+ */
+template<uint16_t N> class SpscRing {
+  static_assert(N != 0 && (N & (N - 1)) == 0 && N <= 32768, "ring size must be a power of two up to 32768");
+
+ public:
+  /// Producer side. Returns the number of bytes stored, the rest didn't fit.
+  uint16_t push(const uint8_t *data, uint16_t length) {
+    uint16_t head = this->head_.load(std::memory_order_relaxed);
+    uint16_t tail = this->tail_.load(std::memory_order_acquire);
+    uint16_t free = N - static_cast<uint16_t>(head - tail);
+    if (length > free) {
+      length = free;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+      this->buffer_[static_cast<uint16_t>(head + i) & (N - 1)] = data[i];
+    }
+    this->head_.store(head + length, std::memory_order_release);
+    return length;
+  }
+
+  /// Consumer side. Returns the number of bytes copied to data.
+  uint16_t pop(uint8_t *data, uint16_t max) {
+    uint16_t tail = this->tail_.load(std::memory_order_relaxed);
+    uint16_t head = this->head_.load(std::memory_order_acquire);
+    uint16_t length = static_cast<uint16_t>(head - tail);
+    if (length > max) {
+      length = max;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+      data[i] = this->buffer_[static_cast<uint16_t>(tail + i) & (N - 1)];
+    }
+    this->tail_.store(tail + length, std::memory_order_release);
+    return length;
+  }
+
+  /// Bytes waiting, exact on the consumer side.
+  uint16_t size() const {
+    return static_cast<uint16_t>(this->head_.load(std::memory_order_acquire) -
+                                 this->tail_.load(std::memory_order_relaxed));
+  }
+
+ protected:
+  uint8_t buffer_[N];
+  std::atomic<uint16_t> head_{0};
+  std::atomic<uint16_t> tail_{0};
+};
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
@@ -0,0 +1,131 @@
+#include "toshiba_transactions.h"
+#include "toshiba_climate.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+bool ToshibaTransactions::start(ToshibaCommandType reg, ToshibaReplyHandler on_reply,
+                                ToshibaTimeoutHandler on_timeout, uint32_t now) {
+  if (this->find_(reg) != nullptr) {
+    ESP_LOGV(TAG, "Transaction for register %d is already running", static_cast<uint8_t>(reg));
+    return false;
+  }
+  for (auto &transaction : this->transactions_) {
+    if (!transaction.active) {
+      transaction = Transaction{reg, true, now, on_reply, on_timeout};
+      return true;
+    }
+  }
+  ESP_LOGW(TAG, "No free transaction slot for register %d", static_cast<uint8_t>(reg));
+  return false;
+}
+
+bool ToshibaTransactions::is_running(ToshibaCommandType reg) const {
+  for (const auto &transaction : this->transactions_) {
+    if (transaction.active && transaction.reg == reg) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ToshibaTransactions::read_sent(ToshibaCommandType reg, uint32_t now) {
+  auto i = static_cast<uint8_t>(reg);
+  this->outstanding_[i / 32] |= 1u << (i % 32);
+  this->in_flight_ = reg;
+  this->in_flight_sent_at_ = now;
+}
+
+bool ToshibaTransactions::frame_received(ToshibaCommandType reg) {
+  auto i = static_cast<uint8_t>(reg);
+  uint32_t mask = 1u << (i % 32);
+  if (this->in_flight_.has_value() && *this->in_flight_ == reg) {
+    this->in_flight_.reset();
+  }
+  if (!(this->outstanding_[i / 32] & mask)) {
+    return false;
+  }
+  this->outstanding_[i / 32] &= ~mask;
+  return true;
+}
+
+void ToshibaTransactions::complete(ToshibaClimateUart *owner, ToshibaCommandType reg, uint8_t value) {
+  auto *transaction = this->find_(reg);
+  if (transaction == nullptr) {
+    return;
+  }
+  // free the slot first, the handler may continue with the next transaction
+  auto on_reply = transaction->on_reply;
+  transaction->active = false;
+  if (on_reply != nullptr) {
+    (owner->*on_reply)(value);
+  }
+}
+
+void ToshibaTransactions::check_timeouts(ToshibaClimateUart *owner, uint32_t now) {
+  if (this->in_flight_.has_value() && !this->awaiting_reply(now)) {
+    // a frame of the register arriving later is a push
+    auto i = static_cast<uint8_t>(*this->in_flight_);
+    this->outstanding_[i / 32] &= ~(1u << (i % 32));
+    this->in_flight_.reset();
+  }
+  for (auto &transaction : this->transactions_) {
+    if (transaction.active && now - transaction.started_at > TIMEOUT) {
+      ESP_LOGD(TAG, "Transaction for register %d timed out", static_cast<uint8_t>(transaction.reg));
+      fail_(owner, transaction);
+    }
+  }
+}
+
+optional<uint32_t> ToshibaTransactions::next_deadline() const {
+  optional<uint32_t> deadline;
+  if (this->in_flight_.has_value()) {
+    deadline = this->in_flight_sent_at_ + REPLY_WAIT;
+  }
+  for (const auto &transaction : this->transactions_) {
+    uint32_t expires = transaction.started_at + TIMEOUT + 1;
+    if (transaction.active && (!deadline.has_value() || (int32_t) (expires - *deadline) < 0)) {
+      deadline = expires;
+    }
+  }
+  return deadline;
+}
+
+void ToshibaTransactions::fail(ToshibaClimateUart *owner, ToshibaCommandType reg) {
+  auto *transaction = this->find_(reg);
+  if (transaction != nullptr) {
+    fail_(owner, *transaction);
+  }
+}
+
+void ToshibaTransactions::fail_all(ToshibaClimateUart *owner) {
+  for (auto &transaction : this->transactions_) {
+    if (transaction.active) {
+      fail_(owner, transaction);
+    }
+  }
+  for (auto &bits : this->outstanding_) {
+    bits = 0;
+  }
+  this->in_flight_.reset();
+}
+
+ToshibaTransactions::Transaction *ToshibaTransactions::find_(ToshibaCommandType reg) {
+  for (auto &transaction : this->transactions_) {
+    if (transaction.active && transaction.reg == reg) {
+      return &transaction;
+    }
+  }
+  return nullptr;
+}
+
+void ToshibaTransactions::fail_(ToshibaClimateUart *owner, Transaction &transaction) {
+  auto on_timeout = transaction.on_timeout;
+  transaction.active = false;
+  if (on_timeout != nullptr) {
+    (owner->*on_timeout)();
+  }
+}
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
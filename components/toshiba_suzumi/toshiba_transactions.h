@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include "toshiba_climate_mode.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+class ToshibaClimateUart;
+
+/// Called with the value when the unit replied to the transaction's read.
+using ToshibaReplyHandler = void (ToshibaClimateUart::*)(uint8_t value);
+/// Called when the unit didn't reply in time or the link was lost.
+using ToshibaTimeoutHandler = void (ToshibaClimateUart::*)();
+
+/**
+ * Matches replies to the reads sent to the unit by register.
+ *
+ * Every sent read is outstanding until a frame of its register arrives or REPLY_WAIT passed
+ * (the reply was lost, e.g. by a checksum error); frames of registers which are not outstanding
+ * are unsolicited (pushed by the unit). On top of that,
+ * a transaction attaches handlers to a read, so a multi-step flow can continue
+ * with the next read once the previous one was answered instead of relying on reply order.
+ * Handlers are member function pointers, so transactions are fixed size and never allocate.
+ */
+class ToshibaTransactions {
+ public:
+  static const uint8_t SLOTS = 4;
+  // transaction not answered within the timeout (queue wait included) fails
+  static const uint32_t TIMEOUT = 5000;
+  // max time the line is kept reserved for the reply to the last sent read
+  static const uint32_t REPLY_WAIT = 300;
+
+  /**
+   * Start a transaction for the register, the caller enqueues the read.
+   * Returns false when a transaction for the register is already running or no slot is free.
+   */
+  bool start(ToshibaCommandType reg, ToshibaReplyHandler on_reply, ToshibaTimeoutHandler on_timeout, uint32_t now);
+  bool is_running(ToshibaCommandType reg) const;
+
+  void read_sent(ToshibaCommandType reg, uint32_t now);
+  /// Returns true when the frame replies to a sent read, false when it's unsolicited.
+  bool frame_received(ToshibaCommandType reg);
+  /// The read sent last was not answered yet and may still be.
+  bool awaiting_reply(uint32_t now) const {
+    return this->in_flight_.has_value() && now - this->in_flight_sent_at_ < REPLY_WAIT;
+  }
+
+  /// Call the reply handler of the register's transaction, if any.
+  void complete(ToshibaClimateUart *owner, ToshibaCommandType reg, uint8_t value);
+  /// Give up the reply to the last read after REPLY_WAIT and call the timeout handlers of expired transactions.
+  void check_timeouts(ToshibaClimateUart *owner, uint32_t now);
+  /// Earliest time check_timeouts() or awaiting_reply() change, when any transaction or read is pending.
+  optional<uint32_t> next_deadline() const;
+  /// Fail the register's transaction right away, e.g. when its read was not sent.
+  void fail(ToshibaClimateUart *owner, ToshibaCommandType reg);
+  /// Fail all transactions, their reads won't be answered.
+  void fail_all(ToshibaClimateUart *owner);
+
+ protected:
+  struct Transaction {
+    ToshibaCommandType reg;
+    bool active;
+    uint32_t started_at;
+    ToshibaReplyHandler on_reply;
+    ToshibaTimeoutHandler on_timeout;
+  };
+  Transaction *find_(ToshibaCommandType reg);
+  static void fail_(ToshibaClimateUart *owner, Transaction &transaction);
+
+  Transaction transactions_[SLOTS]{};
+  // registers with a sent and not answered read, one bit per register
+  uint32_t outstanding_[8]{};
+  optional<ToshibaCommandType> in_flight_;
+  uint32_t in_flight_sent_at_ = 0;
+};
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
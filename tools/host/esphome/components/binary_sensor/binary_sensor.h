@@ -0,0 +1,29 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace binary_sensor {
+
+class BinarySensor {
+ public:
+  void publish_state(bool state) {
+    this->state = state;
+    this->publish_count_++;
+  }
+  uint32_t get_publish_count() const { return this->publish_count_; }
+
+  bool state{false};
+
+ protected:
+  uint32_t publish_count_{0};
+};
+
+}  // namespace binary_sensor
+}  // namespace esphome
+
+#define LOG_BINARY_SENSOR(prefix, type, obj) \
+  if ((obj) != nullptr) { \
+    ESP_LOGCONFIG(TAG, "%s%s", prefix, type); \
+  }
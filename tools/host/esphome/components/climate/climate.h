@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+#include "esphome/core/component.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace climate {
+
+enum ClimateMode : uint8_t {
+  CLIMATE_MODE_OFF,
+  CLIMATE_MODE_HEAT_COOL,
+  CLIMATE_MODE_COOL,
+  CLIMATE_MODE_HEAT,
+  CLIMATE_MODE_FAN_ONLY,
+  CLIMATE_MODE_DRY,
+  CLIMATE_MODE_AUTO,
+};
+enum ClimateFanMode : uint8_t {
+  CLIMATE_FAN_ON,
+  CLIMATE_FAN_OFF,
+  CLIMATE_FAN_AUTO,
+  CLIMATE_FAN_LOW,
+  CLIMATE_FAN_MEDIUM,
+  CLIMATE_FAN_HIGH,
+  CLIMATE_FAN_MIDDLE,
+  CLIMATE_FAN_FOCUS,
+  CLIMATE_FAN_DIFFUSE,
+  CLIMATE_FAN_QUIET,
+};
+enum ClimateSwingMode : uint8_t {
+  CLIMATE_SWING_OFF,
+  CLIMATE_SWING_BOTH,
+  CLIMATE_SWING_VERTICAL,
+  CLIMATE_SWING_HORIZONTAL,
+};
+enum ClimatePreset : uint8_t {
+  CLIMATE_PRESET_NONE,
+  CLIMATE_PRESET_HOME,
+  CLIMATE_PRESET_AWAY,
+  CLIMATE_PRESET_BOOST,
+  CLIMATE_PRESET_COMFORT,
+  CLIMATE_PRESET_ECO,
+  CLIMATE_PRESET_SLEEP,
+  CLIMATE_PRESET_ACTIVITY,
+};
+enum ClimateFeature : uint32_t {
+  CLIMATE_SUPPORTS_CURRENT_TEMPERATURE = 1 << 0,
+};
+
+const LogString *climate_mode_to_string(ClimateMode mode);
+const LogString *climate_fan_mode_to_string(ClimateFanMode mode);
+const LogString *climate_swing_mode_to_string(ClimateSwingMode mode);
+
+/// Supported modes are kept as bit masks, as ESPHome does.
+class ClimateTraits {
+ public:
+  void set_supported_modes(std::initializer_list<ClimateMode> modes) { this->modes_ = mask_(modes); }
+  void set_supported_swing_modes(std::initializer_list<ClimateSwingMode> modes) { this->swing_modes_ = mask_(modes); }
+  void add_supported_fan_mode(ClimateFanMode mode) { this->fan_modes_ |= 1u << mode; }
+  void add_supported_preset(ClimatePreset preset) { this->presets_ |= 1u << preset; }
+  void add_feature_flags(uint32_t flags) { this->feature_flags_ |= flags; }
+  void set_visual_temperature_step(float step) { this->visual_temperature_step_ = step; }
+  void set_visual_min_temperature(float min) { this->visual_min_temperature_ = min; }
+  void set_visual_max_temperature(float max) { this->visual_max_temperature_ = max; }
+
+  bool supports_mode(ClimateMode mode) const { return this->modes_ & (1u << mode); }
+  bool supports_fan_mode(ClimateFanMode mode) const { return this->fan_modes_ & (1u << mode); }
+  bool supports_swing_mode(ClimateSwingMode mode) const { return this->swing_modes_ & (1u << mode); }
+  bool supports_preset(ClimatePreset preset) const { return this->presets_ & (1u << preset); }
+  float get_visual_min_temperature() const { return this->visual_min_temperature_; }
+  float get_visual_max_temperature() const { return this->visual_max_temperature_; }
+
+ protected:
+  template<typename T> static uint32_t mask_(std::initializer_list<T> values) {
+    uint32_t mask = 0;
+    for (auto value : values)
+      mask |= 1u << value;
+    return mask;
+  }
+
+  uint32_t modes_{0};
+  uint32_t fan_modes_{0};
+  uint32_t swing_modes_{0};
+  uint32_t presets_{0};
+  uint32_t feature_flags_{0};
+  float visual_temperature_step_{0.5f};
+  float visual_min_temperature_{10};
+  float visual_max_temperature_{30};
+};
+
+class Climate;
+
+/// Request to change the state, perform() passes it to Climate::control().
+class ClimateCall {
+ public:
+  explicit ClimateCall(Climate *parent) : parent_(parent) {}
+
+  ClimateCall &set_mode(ClimateMode mode) {
+    this->mode_ = mode;
+    return *this;
+  }
+  ClimateCall &set_target_temperature(float target_temperature) {
+    this->target_temperature_ = target_temperature;
+    return *this;
+  }
+  ClimateCall &set_fan_mode(ClimateFanMode fan_mode) {
+    this->fan_mode_ = fan_mode;
+    return *this;
+  }
+  ClimateCall &set_fan_mode(const char *custom_fan_mode) {
+    this->custom_fan_mode_ = custom_fan_mode;
+    return *this;
+  }
+  ClimateCall &set_swing_mode(ClimateSwingMode swing_mode) {
+    this->swing_mode_ = swing_mode;
+    return *this;
+  }
+  ClimateCall &set_preset(ClimatePreset preset) {
+    this->preset_ = preset;
+    return *this;
+  }
+  ClimateCall &set_preset(const char *custom_preset) {
+    this->custom_preset_ = custom_preset;
+    return *this;
+  }
+  void perform();
+
+  const optional<ClimateMode> &get_mode() const { return this->mode_; }
+  const optional<float> &get_target_temperature() const { return this->target_temperature_; }
+  const optional<ClimateFanMode> &get_fan_mode() const { return this->fan_mode_; }
+  const optional<ClimateSwingMode> &get_swing_mode() const { return this->swing_mode_; }
+  const optional<ClimatePreset> &get_preset() const { return this->preset_; }
+  bool has_custom_fan_mode() const { return this->custom_fan_mode_ != nullptr; }
+  std::string get_custom_fan_mode() const { return this->custom_fan_mode_; }
+  bool has_custom_preset() const { return this->custom_preset_ != nullptr; }
+  std::string get_custom_preset() const { return this->custom_preset_; }
+
+ protected:
+  Climate *parent_;
+  optional<ClimateMode> mode_;
+  optional<float> target_temperature_;
+  optional<ClimateFanMode> fan_mode_;
+  optional<ClimateSwingMode> swing_mode_;
+  optional<ClimatePreset> preset_;
+  const char *custom_fan_mode_{nullptr};
+  const char *custom_preset_{nullptr};
+};
+
+/**
+ * Host stand-in of ESPHome's climate entity. Custom modes are kept as pointers into
+ * the lists of supported ones, so setting them doesn't allocate.
+ */
+class Climate {
+ public:
+  virtual ~Climate() = default;
+
+  ClimateCall make_call() { return ClimateCall(this); }
+  void publish_state() { this->publish_count_++; }
+  ClimateTraits get_traits() { return this->traits(); }
+
+  void set_name(const char *name) { this->name_ = name; }
+  const char *get_name() const { return this->name_; }
+  uint32_t get_object_id_hash() { return fnv1_hash(this->name_); }
+  uint32_t get_publish_count() const { return this->publish_count_; }
+  const char *get_custom_fan_mode() const { return this->custom_fan_mode_; }
+  const char *get_custom_preset() const { return this->custom_preset_; }
+
+  void set_supported_custom_fan_modes(std::initializer_list<const char *> modes) {
+    this->supported_custom_fan_modes_ = modes;
+  }
+  void set_supported_custom_presets(const std::vector<const char *> &presets) {
+    this->supported_custom_presets_ = presets;
+  }
+
+  ClimateMode mode{CLIMATE_MODE_OFF};
+  float current_temperature{0};
+  float target_temperature{0};
+  optional<ClimateFanMode> fan_mode;
+  ClimateSwingMode swing_mode{CLIMATE_SWING_OFF};
+  optional<ClimatePreset> preset;
+
+ protected:
+  friend ClimateCall;
+
+  virtual void control(const ClimateCall &call) = 0;
+  virtual ClimateTraits traits() = 0;
+
+  bool set_fan_mode_(ClimateFanMode mode);
+  bool set_custom_fan_mode_(const char *mode);
+  bool set_custom_fan_mode_(const std::string &mode) { return this->set_custom_fan_mode_(mode.c_str()); }
+  bool set_preset_(ClimatePreset preset);
+  bool set_custom_preset_(const char *preset);
+  bool set_custom_preset_(const std::string &preset) { return this->set_custom_preset_(preset.c_str()); }
+
+  const char *name_{"climate"};
+  uint32_t publish_count_{0};
+  std::vector<const char *> supported_custom_fan_modes_;
+  std::vector<const char *> supported_custom_presets_;
+  const char *custom_fan_mode_{nullptr};
+  const char *custom_preset_{nullptr};
+};
+
+}  // namespace climate
+}  // namespace esphome
+
+#define LOG_CLIMATE(prefix, type, obj) ESP_LOGCONFIG(TAG, "%s%s '%s'", prefix, type, (obj)->get_name())
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+#include "esphome/core/component.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace select {
+
+class Select {
+ public:
+  virtual ~Select() = default;
+
+  void publish_state(const std::string &state) { this->publish_state(state.c_str()); }
+  void publish_state(const char *state) {
+    strncpy(this->state_, state, sizeof(this->state_) - 1);
+    this->publish_count_++;
+  }
+  const char *current_option() const { return this->state_; }
+  uint32_t get_publish_count() const { return this->publish_count_; }
+
+ protected:
+  virtual void control(const std::string &value) = 0;
+
+  char state_[32]{};
+  uint32_t publish_count_{0};
+};
+
+}  // namespace select
+}  // namespace esphome
+
+#define LOG_SELECT(prefix, type, obj) \
+  if ((obj) != nullptr) { \
+    ESP_LOGCONFIG(TAG, "%s%s '%s'", prefix, type, (obj)->current_option()); \
+  }
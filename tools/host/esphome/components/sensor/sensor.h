@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cmath>
+#include "esphome/core/component.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace sensor {
+
+class Sensor {
+ public:
+  void publish_state(float state) {
+    this->state = state;
+    this->has_state_ = true;
+    this->publish_count_++;
+  }
+  bool has_state() const { return this->has_state_; }
+  uint32_t get_publish_count() const { return this->publish_count_; }
+
+  float state{NAN};
+
+ protected:
+  bool has_state_{false};
+  uint32_t publish_count_{0};
+};
+
+}  // namespace sensor
+}  // namespace esphome
+
+#define LOG_SENSOR(prefix, type, obj) \
+  if ((obj) != nullptr) { \
+    ESP_LOGCONFIG(TAG, "%s%s", prefix, type); \
+  }
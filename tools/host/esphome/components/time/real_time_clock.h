@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include "esphome/core/component.h"
+
+namespace esphome {
+
+struct ESPTime {
+  uint8_t second;
+  uint8_t minute;
+  uint8_t hour;
+  uint8_t day_of_week;  // 1 = Sunday
+  uint8_t day_of_month;
+  uint16_t day_of_year;
+  uint8_t month;  // 1 = January
+  uint16_t year;
+  bool is_dst;
+  time_t timestamp;
+
+  bool is_valid() const { return this->year >= 2019; }
+  /// Calendar time in UTC, without the C library (which may allocate for time zones).
+  static ESPTime from_epoch_utc(time_t epoch);
+};
+
+namespace time {
+
+/// Clock following the virtual clock of host.h, from the epoch set by set_epoch().
+class RealTimeClock {
+ public:
+  void set_epoch(time_t epoch) {
+    this->epoch_ = epoch;
+    this->set_at_ = millis();
+  }
+  ESPTime now() {
+    if (this->epoch_ == 0)
+      return ESPTime{};
+    return ESPTime::from_epoch_utc(this->epoch_ + (millis() - this->set_at_) / 1000);
+  }
+
+ protected:
+  time_t epoch_{0};
+  uint32_t set_at_{0};
+};
+
+}  // namespace time
+}  // namespace esphome
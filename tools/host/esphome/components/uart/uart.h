@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace uart {
+
+/// The bus the device talks over, on the host e.g. a simulated unit.
+class UARTComponent {
+ public:
+  virtual ~UARTComponent() = default;
+  virtual void write_array(const uint8_t *data, size_t len) = 0;
+  virtual int available() = 0;
+  virtual bool read_array(uint8_t *data, size_t len) = 0;
+};
+
+class UARTDevice {
+ public:
+  UARTDevice() = default;
+  explicit UARTDevice(UARTComponent *parent) : parent_(parent) {}
+
+  void set_uart_parent(UARTComponent *parent) { this->parent_ = parent; }
+
+  int available() { return this->parent_->available(); }
+  bool read_byte(uint8_t *data) { return this->parent_->read_array(data, 1); }
+  bool read_array(uint8_t *data, size_t len) { return this->parent_->read_array(data, len); }
+  void write_array(const uint8_t *data, size_t len) { this->parent_->write_array(data, len); }
+  void write_array(const std::vector<uint8_t> &data) { this->parent_->write_array(data.data(), data.size()); }
+
+ protected:
+  UARTComponent *parent_{nullptr};
+};
+
+}  // namespace uart
+}  // namespace esphome
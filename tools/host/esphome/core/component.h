@@ -0,0 +1,69 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/optional.h"
+
+namespace esphome {
+
+namespace setup_priority {
+extern const float HARDWARE;
+extern const float DATA;
+extern const float LATE;
+}  // namespace setup_priority
+
+/**
+ * Host stand-in of ESPHome's Component. Timers run on the virtual clock of host.h,
+ * like on the devices each set_timeout()/set_interval() allocates a scheduler item.
+ */
+class Component {
+ public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return setup_priority::DATA; }
+  virtual void on_shutdown() {}
+  virtual void on_safe_shutdown() {}
+  /// Called once after setup(), PollingComponent starts its poller here.
+  virtual void call_setup() { this->setup(); }
+
+  void mark_failed() { this->failed_ = true; }
+  bool is_failed() const { return this->failed_; }
+  void status_set_warning(const char * = nullptr) { this->warning_ = true; }
+  void status_clear_warning() { this->warning_ = false; }
+
+ protected:
+  void set_timeout(const char *name, uint32_t timeout, std::function<void()> &&f);
+  void set_timeout(uint32_t timeout, std::function<void()> &&f);
+  bool cancel_timeout(const char *name);
+  void set_interval(const char *name, uint32_t interval, std::function<void()> &&f);
+  void set_interval(uint32_t interval, std::function<void()> &&f);
+  bool cancel_interval(const char *name);
+  void defer(std::function<void()> &&f) { this->set_timeout(0, std::move(f)); }
+
+  bool failed_{false};
+  bool warning_{false};
+};
+
+class PollingComponent : public Component {
+ public:
+  PollingComponent() : PollingComponent(0) {}
+  explicit PollingComponent(uint32_t update_interval) : update_interval_(update_interval) {}
+
+  virtual void update() = 0;
+  virtual void set_update_interval(uint32_t update_interval) { this->update_interval_ = update_interval; }
+  virtual uint32_t get_update_interval() const { return this->update_interval_; }
+  void call_setup() override;
+  void start_poller();
+  void stop_poller();
+
+ protected:
+  uint32_t update_interval_;
+};
+
+}  // namespace esphome
@@ -0,0 +1,36 @@
+#pragma once
+
+// Features of the host build, ESPHome generates this file from the configuration.
+// The RX task needs FreeRTOS and is not built on the host.
+#define USE_HOST
+#define USE_TIME
+#define USE_TOSHIBA_SUZUMI_INDOOR_TEMP
+#define USE_TOSHIBA_SUZUMI_OUTDOOR_TEMP
+#define USE_TOSHIBA_SUZUMI_ODU_STATUS
+#define USE_TOSHIBA_SUZUMI_IDU_STATUS
+#define USE_TOSHIBA_SUZUMI_TIME_SYNC
+#define USE_TOSHIBA_SUZUMI_ENERGY
+#define USE_TOSHIBA_SUZUMI_PWR_SELECT
+#define USE_TOSHIBA_SUZUMI_VERTICAL_AIR_DIRECTION
+#define USE_TOSHIBA_SUZUMI_SELF_CLEAN
+#define USE_TOSHIBA_SUZUMI_LINK_STATS
+#define USE_TOSHIBA_SUZUMI_LATENCY_REPORT
+#define USE_TOSHIBA_SUZUMI_RAW_REGISTER
+#define USE_TOSHIBA_SUZUMI_REGISTER_TRIGGERS
+#define USE_TOSHIBA_SUZUMI_CONNECTED
+#define USE_TOSHIBA_SUZUMI_PROFILE
+#define USE_TOSHIBA_SUZUMI_CAPTURE
+#define USE_TOSHIBA_SUZUMI_OUTDOOR_UNIT
+
+#define ESPHOME_LOG_LEVEL_NONE 0
+#define ESPHOME_LOG_LEVEL_ERROR 1
+#define ESPHOME_LOG_LEVEL_WARN 2
+#define ESPHOME_LOG_LEVEL_INFO 3
+#define ESPHOME_LOG_LEVEL_CONFIG 4
+#define ESPHOME_LOG_LEVEL_DEBUG 5
+#define ESPHOME_LOG_LEVEL_VERBOSE 6
+#define ESPHOME_LOG_LEVEL_VERY_VERBOSE 7
+// ESPHome's default, verbose messages are compiled out as on the devices
+#ifndef ESPHOME_LOG_LEVEL
+#define ESPHOME_LOG_LEVEL ESPHOME_LOG_LEVEL_DEBUG
+#endif
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+
+// the host build runs on a virtual clock, see host.h
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+}  // namespace esphome
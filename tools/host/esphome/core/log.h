@@ -0,0 +1,34 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+// flash strings are plain strings on the host
+struct LogString;
+#define LOG_STR(s) (reinterpret_cast<const esphome::LogString *>(s))
+#define LOG_STR_ARG(s) (reinterpret_cast<const char *>(s))
+
+void esp_log_printf_(int level, const char *tag, int line, const char *format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+}  // namespace esphome
+
+#define ESPHOME_LOG_(level, tag, ...) ::esphome::esp_log_printf_(level, tag, __LINE__, __VA_ARGS__)
+
+#define ESP_LOGE(tag, ...) ESPHOME_LOG_(ESPHOME_LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ESPHOME_LOG_(ESPHOME_LOG_LEVEL_WARN, tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ESPHOME_LOG_(ESPHOME_LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ESPHOME_LOG_(ESPHOME_LOG_LEVEL_CONFIG, tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ESPHOME_LOG_(ESPHOME_LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_VERBOSE
+#define ESP_LOGV(tag, ...) ESPHOME_LOG_(ESPHOME_LOG_LEVEL_VERBOSE, tag, __VA_ARGS__)
+#else
+#define ESP_LOGV(tag, ...) ((void) 0)
+#endif
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_VERY_VERBOSE
+#define ESP_LOGVV(tag, ...) ESPHOME_LOG_(ESPHOME_LOG_LEVEL_VERY_VERBOSE, tag, __VA_ARGS__)
+#else
+#define ESP_LOGVV(tag, ...) ((void) 0)
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <optional>
+
+namespace esphome {
+
+template<typename T> using optional = std::optional<T>;
+constexpr std::nullopt_t nullopt = std::nullopt;
+
+}  // namespace esphome
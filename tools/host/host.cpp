@@ -0,0 +1,308 @@
+#include "host.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+#include "esphome/core/component.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+#include "esphome/components/climate/climate.h"
+#include "esphome/components/time/real_time_clock.h"
+
+namespace esphome {
+
+namespace setup_priority {
+const float HARDWARE = 800.0f;
+const float DATA = 600.0f;
+const float LATE = -100.0f;
+}  // namespace setup_priority
+
+namespace {
+
+uint64_t now_us_ = 0;
+uint32_t loop_interval_ = 16;
+int log_level_ = ESPHOME_LOG_LEVEL_WARN;
+std::vector<Component *> components_;
+
+struct SchedulerItem {
+  Component *component;
+  const char *name;
+  uint64_t next_us;
+  uint32_t interval;
+  bool is_interval;
+  bool removed;
+  std::function<void()> callback;
+};
+
+/**
+ * Items are allocated one by one and kept in creation order, due ones run in the order of their
+ * deadline. Like ESPHome's scheduler, a new item replaces the pending one of the same name.
+ */
+class Scheduler {
+ public:
+  void add(Component *component, const char *name, uint32_t delay, bool is_interval, std::function<void()> &&f) {
+    if (name != nullptr) {
+      this->cancel(component, name, is_interval);
+    }
+    this->items_.push_back(std::unique_ptr<SchedulerItem>(new SchedulerItem{
+        component, name, now_us_ + delay * 1000ull, delay, is_interval, false, std::move(f)}));
+    this->created_++;
+  }
+
+  bool cancel(Component *component, const char *name, bool is_interval) {
+    bool found = false;
+    for (auto &item : this->items_) {
+      if (!item->removed && item->component == component && item->is_interval == is_interval &&
+          item->name != nullptr && strcmp(item->name, name) == 0) {
+        item->removed = true;
+        found = true;
+      }
+    }
+    return found;
+  }
+
+  void call() {
+    SchedulerItem *next;
+    while ((next = this->next_due_()) != nullptr) {
+      if (next->is_interval) {
+        next->next_us += next->interval == 0 ? 1000 : next->interval * 1000ull;
+        if (next->next_us <= now_us_) {
+          next->next_us = now_us_ + next->interval * 1000ull;
+        }
+      } else {
+        next->removed = true;
+      }
+      // the callback may add items, which moves the unique pointers, not the items
+      auto callback = std::move(next->callback);
+      callback();
+      if (next->is_interval && !next->removed) {
+        next->callback = std::move(callback);
+      }
+    }
+    this->cleanup_();
+  }
+
+  uint32_t created() const { return this->created_; }
+
+ protected:
+  SchedulerItem *next_due_() {
+    SchedulerItem *next = nullptr;
+    for (auto &item : this->items_) {
+      if (!item->removed && item->next_us <= now_us_ && (next == nullptr || item->next_us < next->next_us)) {
+        next = item.get();
+      }
+    }
+    return next;
+  }
+
+  void cleanup_() {
+    size_t kept = 0;
+    for (size_t i = 0; i < this->items_.size(); i++) {
+      if (!this->items_[i]->removed) {
+        this->items_[kept++] = std::move(this->items_[i]);
+      }
+    }
+    this->items_.resize(kept);
+  }
+
+  std::vector<std::unique_ptr<SchedulerItem>> items_;
+  uint32_t created_ = 0;
+};
+
+Scheduler scheduler_;
+
+class HostPreferences : public ESPPreferences {
+ public:
+  ESPPreferenceObject make_preference(size_t, uint32_t type, bool) override {
+    return ESPPreferenceObject(&this->data_[type]);
+  }
+  bool sync() override { return true; }
+
+ protected:
+  std::map<uint32_t, std::vector<uint8_t>> data_;
+};
+
+HostPreferences preferences_;
+
+}  // namespace
+
+ESPPreferences *global_preferences = &preferences_;
+
+uint32_t millis() { return now_us_ / 1000; }
+uint32_t micros() { return now_us_; }
+void delay(uint32_t ms) { now_us_ += ms * 1000ull; }
+
+void esp_log_printf_(int level, const char *tag, int line, const char *format, ...) {
+  if (level > log_level_) {
+    return;
+  }
+  static const char LETTERS[] = "?EWICDVV";
+  char message[512];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(message, sizeof(message), format, args);
+  va_end(args);
+  fprintf(stderr, "%10.3f [%c][%s:%d]: %s\n", now_us_ / 1e6, LETTERS[level], tag, line, message);
+}
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= c;
+  }
+  return hash;
+}
+
+bool str_equals_case_insensitive(const std::string &a, const std::string &b) {
+  return a.size() == b.size() && strncasecmp(a.c_str(), b.c_str(), a.size()) == 0;
+}
+
+void Component::set_timeout(const char *name, uint32_t timeout, std::function<void()> &&f) {
+  scheduler_.add(this, name, timeout, false, std::move(f));
+}
+void Component::set_timeout(uint32_t timeout, std::function<void()> &&f) {
+  scheduler_.add(this, nullptr, timeout, false, std::move(f));
+}
+bool Component::cancel_timeout(const char *name) { return scheduler_.cancel(this, name, false); }
+void Component::set_interval(const char *name, uint32_t interval, std::function<void()> &&f) {
+  scheduler_.add(this, name, interval, true, std::move(f));
+}
+void Component::set_interval(uint32_t interval, std::function<void()> &&f) {
+  scheduler_.add(this, nullptr, interval, true, std::move(f));
+}
+bool Component::cancel_interval(const char *name) { return scheduler_.cancel(this, name, true); }
+
+void PollingComponent::call_setup() {
+  this->setup();
+  this->start_poller();
+}
+void PollingComponent::start_poller() {
+  if (this->update_interval_ != 0) {
+    this->set_interval("update", this->update_interval_, [this]() { this->update(); });
+  }
+}
+void PollingComponent::stop_poller() { this->cancel_interval("update"); }
+
+// days since 1970-01-01 to the civil date, http://howardhinnant.github.io/date_algorithms.html
+ESPTime ESPTime::from_epoch_utc(time_t epoch) {
+  ESPTime time{};
+  int64_t days = epoch / 86400;
+  int64_t seconds = epoch % 86400;
+  time.hour = seconds / 3600;
+  time.minute = seconds / 60 % 60;
+  time.second = seconds % 60;
+  time.day_of_week = (days + 4) % 7 + 1;
+  int64_t z = days + 719468;
+  int64_t era = z / 146097;
+  int64_t doe = z - era * 146097;
+  int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int64_t mp = (5 * doy + 2) / 153;
+  time.day_of_month = doy - (153 * mp + 2) / 5 + 1;
+  time.month = mp < 10 ? mp + 3 : mp - 9;
+  time.year = yoe + era * 400 + (time.month <= 2);
+  bool leap = (time.year % 4 == 0 && time.year % 100 != 0) || time.year % 400 == 0;
+  // doy counts from March 1st
+  time.day_of_year = (doy + 59 + leap) % (365 + leap) + 1;
+  time.timestamp = epoch;
+  return time;
+}
+
+namespace climate {
+
+static const char *const MODE_NAMES[] = {"OFF", "HEAT_COOL", "COOL", "HEAT", "FAN_ONLY", "DRY", "AUTO"};
+static const char *const FAN_MODE_NAMES[] = {"ON",     "OFF",   "AUTO",  "LOW",     "MEDIUM",
+                                             "HIGH",   "MIDDLE", "FOCUS", "DIFFUSE", "QUIET"};
+static const char *const SWING_MODE_NAMES[] = {"OFF", "BOTH", "VERTICAL", "HORIZONTAL"};
+
+const LogString *climate_mode_to_string(ClimateMode mode) {
+  return LOG_STR(mode <= CLIMATE_MODE_AUTO ? MODE_NAMES[mode] : "UNKNOWN");
+}
+const LogString *climate_fan_mode_to_string(ClimateFanMode mode) {
+  return LOG_STR(mode <= CLIMATE_FAN_QUIET ? FAN_MODE_NAMES[mode] : "UNKNOWN");
+}
+const LogString *climate_swing_mode_to_string(ClimateSwingMode mode) {
+  return LOG_STR(mode <= CLIMATE_SWING_HORIZONTAL ? SWING_MODE_NAMES[mode] : "UNKNOWN");
+}
+
+void ClimateCall::perform() { this->parent_->control(*this); }
+
+bool Climate::set_fan_mode_(ClimateFanMode mode) {
+  bool changed = this->fan_mode != mode || this->custom_fan_mode_ != nullptr;
+  this->fan_mode = mode;
+  this->custom_fan_mode_ = nullptr;
+  return changed;
+}
+
+bool Climate::set_custom_fan_mode_(const char *mode) {
+  for (const char *supported : this->supported_custom_fan_modes_) {
+    if (strcmp(supported, mode) == 0) {
+      bool changed = this->custom_fan_mode_ != supported;
+      this->custom_fan_mode_ = supported;
+      this->fan_mode.reset();
+      return changed;
+    }
+  }
+  return false;
+}
+
+bool Climate::set_preset_(ClimatePreset preset) {
+  bool changed = this->preset != preset || this->custom_preset_ != nullptr;
+  this->preset = preset;
+  this->custom_preset_ = nullptr;
+  return changed;
+}
+
+bool Climate::set_custom_preset_(const char *preset) {
+  for (const char *supported : this->supported_custom_presets_) {
+    if (strcmp(supported, preset) == 0) {
+      bool changed = this->custom_preset_ != supported;
+      this->custom_preset_ = supported;
+      this->preset.reset();
+      return changed;
+    }
+  }
+  return false;
+}
+
+}  // namespace climate
+
+namespace host {
+
+void register_component(Component *component) { components_.push_back(component); }
+
+void setup() {
+  std::stable_sort(components_.begin(), components_.end(), [](Component *a, Component *b) {
+    return a->get_setup_priority() > b->get_setup_priority();
+  });
+  for (auto *component : components_) {
+    component->call_setup();
+  }
+  for (auto *component : components_) {
+    component->dump_config();
+  }
+}
+
+void run_for(uint32_t ms) {
+  uint64_t end = now_us_ + ms * 1000ull;
+  while (now_us_ < end) {
+    uint64_t step = loop_interval_ * 1000ull;
+    now_us_ = end - now_us_ < step ? end : now_us_ + step;
+    scheduler_.call();
+    for (auto *component : components_) {
+      component->loop();
+    }
+  }
+}
+
+void set_loop_interval(uint32_t ms) { loop_interval_ = ms == 0 ? 1 : ms; }
+uint64_t now_us() { return now_us_; }
+void set_log_level(int level) { log_level_ = level; }
+uint32_t scheduler_items_created() { return scheduler_.created(); }
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include "esphome/core/component.h"
+
+/**
+ * Minimal host runtime of the ESPHome API used by the component: a virtual clock, the
+ * scheduler behind set_timeout()/set_interval() and the main loop. Time passes only in
+ * run_for(), so runs are deterministic and an hour of operation takes a fraction of a second.
+ */
+
+namespace esphome {
+namespace host {
+
+/// Add the component to the node, setup() calls the components by their setup priority.
+void register_component(Component *component);
+void setup();
+/// Advance the virtual clock by ms, running the main loop every loop interval.
+void run_for(uint32_t ms);
+/// Time between main loop runs, ESPHome's default is 16 ms.
+void set_loop_interval(uint32_t ms);
+uint64_t now_us();
+/// Messages above the level are not printed (the default is ESPHOME_LOG_LEVEL_WARN).
+void set_log_level(int level);
+/// Number of scheduler items (timeouts and intervals) created since the start.
+uint32_t scheduler_items_created();
+
+}  // namespace host
+}  // namespace esphome
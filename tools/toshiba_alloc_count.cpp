@@ -0,0 +1,46 @@
+#include "toshiba_alloc_count.h"
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace alloc_count {
+
+static Counters counters_{};
+static void (*hook_)(size_t) = nullptr;
+// the hook itself may allocate
+static thread_local bool in_hook_ = false;
+
+Counters counters() { return counters_; }
+void set_hook(void (*hook)(size_t size)) { hook_ = hook; }
+
+static void *allocate(size_t size) {
+  void *ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  counters_.allocations++;
+  counters_.bytes += size;
+  counters_.live_bytes += malloc_usable_size(ptr);
+  if (hook_ != nullptr && !in_hook_) {
+    in_hook_ = true;
+    hook_(size);
+    in_hook_ = false;
+  }
+  return ptr;
+}
+
+static void release(void *ptr) {
+  if (ptr != nullptr) {
+    counters_.live_bytes -= malloc_usable_size(ptr);
+    free(ptr);
+  }
+}
+
+}  // namespace alloc_count
+
+void *operator new(size_t size) { return alloc_count::allocate(size); }
+void *operator new[](size_t size) { return alloc_count::allocate(size); }
+void operator delete(void *ptr) noexcept { alloc_count::release(ptr); }
+void operator delete[](void *ptr) noexcept { alloc_count::release(ptr); }
+void operator delete(void *ptr, size_t) noexcept { alloc_count::release(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { alloc_count::release(ptr); }
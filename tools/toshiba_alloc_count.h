@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Counts the heap allocations of the program by replacing the global operator new and delete,
+ * see toshiba_alloc_count.cpp. Used by the single-threaded host tools measuring heap use of the component.
+ */
+
+namespace alloc_count {
+
+struct Counters {
+  uint64_t allocations;
+  uint64_t bytes;
+  // allocated and not yet freed
+  int64_t live_bytes;
+};
+
+Counters counters();
+/// Called on each allocation with its size, e.g. to print where it comes from. nullptr removes it.
+void set_hook(void (*hook)(size_t size));
+
+}  // namespace alloc_count
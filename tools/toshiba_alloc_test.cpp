@@ -0,0 +1,121 @@
+// Heap allocations of the component after setup, see "Host tools" in README.md.
+//
+// Usage:
+//   toshiba_alloc_test [-H hours] [-v]
+//
+// Two units (so polls are staggered) connect and warm up against simulated units, then run for the given
+// virtual hours (3 by default) with everything the component does in steady state: polls, IDU/ODU status
+// pushes, energy sync across the full hours, time sync, climate calls, changes by the IR remote (burst
+// polling) and a scan. Any heap allocation in that time fails the test, the first ones are printed with
+// their backtrace (link with -rdynamic to see the function names).
+
+#include <cstdio>
+#include <cstdlib>
+#include <execinfo.h>
+#include <unistd.h>
+#include "toshiba_alloc_count.h"
+#include "toshiba_host_unit.h"
+
+using namespace esphome;
+using namespace esphome::toshiba_suzumi;
+
+namespace {
+
+const uint32_t MINUTE = 60000;
+const uint32_t REPORTED_ALLOCATIONS = 5;
+
+uint32_t reported = 0;
+
+void report_allocation(size_t size) {
+  if (reported++ >= REPORTED_ALLOCATIONS) {
+    return;
+  }
+  fprintf(stderr, "Allocation of %zu bytes at %.3fs:\n", size, host::now_us() / 1e6);
+  void *frames[32];
+  backtrace_symbols_fd(frames, backtrace(frames, 32), STDERR_FILENO);
+}
+
+void perform(ToshibaHostUnit &unit, climate::ClimateMode mode, float target, climate::ClimateFanMode fan_mode) {
+  auto call = unit.climate.make_call();
+  call.set_mode(mode).set_target_temperature(target).set_fan_mode(fan_mode);
+  call.perform();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t hours = 3;
+  // scan() reports each unknown register as a warning
+  host::set_log_level(ESPHOME_LOG_LEVEL_ERROR);
+  int opt;
+  while ((opt = getopt(argc, argv, "H:v")) != -1) {
+    switch (opt) {
+      case 'H':
+        hours = strtoul(optarg, nullptr, 10);
+        break;
+      case 'v':
+        host::set_log_level(ESPHOME_LOG_LEVEL_DEBUG);
+        break;
+      default:
+        hours = 0;
+    }
+  }
+  if (hours == 0) {
+    fprintf(stderr, "Usage: %s [-H hours] [-v]\n", argv[0]);
+    return 2;
+  }
+
+  time::RealTimeClock clock;
+  clock.set_epoch(ToshibaHostUnit::EPOCH);
+  ToshibaUnitSim::Config config;
+  // fast pushes, each of them is decoded and published
+  config.status_interval_ms = 20000;
+  ToshibaHostUnit first(0, config, &clock, 30000);
+  ToshibaHostUnit second(1, config, &clock, 30000);
+  first.climate.set_time_sync_interval(15 * MINUTE);
+  second.climate.set_time_sync_interval(15 * MINUTE);
+
+  host::setup();
+  host::run_for(10 * MINUTE);
+  perform(first, climate::CLIMATE_MODE_HEAT, 23, climate::CLIMATE_FAN_AUTO);
+  perform(second, climate::CLIMATE_MODE_COOL, 21, climate::CLIMATE_FAN_LOW);
+  host::run_for(10 * MINUTE);
+
+  auto before = alloc_count::counters();
+  alloc_count::set_hook(report_allocation);
+  for (uint32_t minute = 0; minute < hours * 60; minute += 5) {
+    switch (minute / 5 % 6) {
+      case 0:
+        perform(first, climate::CLIMATE_MODE_HEAT, 24, climate::CLIMATE_FAN_HIGH);
+        break;
+      case 1:
+        // changed by the IR remote, reported by the unit
+        first.sim.set_register(ToshibaUnitSim::TARGET_TEMP, 20, true, host::now_us());
+        break;
+      case 2:
+        perform(second, climate::CLIMATE_MODE_OFF, 21, climate::CLIMATE_FAN_LOW);
+        break;
+      case 3:
+        second.sim.set_register(ToshibaUnitSim::POWER_STATE, ToshibaUnitSim::POWER_ON, true, host::now_us());
+        break;
+      case 4:
+        perform(first, climate::CLIMATE_MODE_COOL, 22, climate::CLIMATE_FAN_QUIET);
+        break;
+      default:
+        if (minute / 30 % 2 == 0) {
+          first.climate.scan();
+        } else {
+          perform(second, climate::CLIMATE_MODE_HEAT, 25, climate::CLIMATE_FAN_MEDIUM);
+        }
+    }
+    host::run_for(5 * MINUTE);
+  }
+  alloc_count::set_hook(nullptr);
+  auto after = alloc_count::counters();
+
+  uint64_t allocations = after.allocations - before.allocations;
+  bool lost = first.climate.is_link_lost() || second.climate.is_link_lost();
+  printf("%llu heap allocations in %u hours of operation%s\n", (unsigned long long) allocations, hours,
+         lost ? ", a unit lost its link" : "");
+  return allocations == 0 && !lost ? 0 : 1;
+}
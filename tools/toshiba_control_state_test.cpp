@@ -0,0 +1,129 @@
+// Tests of the confirmation tracking of written settings (toshiba_control_state.h), see "Host tools" in README.md.
+//
+// Usage:
+//   toshiba_control_state_test
+//
+// Prints the failed checks and exits with 1 when any check failed.
+
+#include <cstdio>
+#include "host.h"
+#include "toshiba_control_state.h"
+
+using namespace esphome;
+using namespace esphome::toshiba_suzumi;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #condition); \
+      failures++; \
+    } \
+  } while (0)
+
+const uint32_t NOW = 1000;
+
+void test_ack_confirms_write() {
+  ToshibaControlState state;
+  state.expect(ToshibaCommandType::MODE, 67);
+  CHECK(state.state(ToshibaCommandType::MODE) == FieldState::PENDING);
+  state.sent(ToshibaCommandType::MODE, NOW);
+  state.acknowledged();
+  CHECK(state.state(ToshibaCommandType::MODE) == FieldState::CONFIRMED);
+  CHECK(state.holds(ToshibaCommandType::MODE, 67));
+}
+
+void test_ack_confirms_packed_write() {
+  ToshibaControlState state;
+  const ToshibaCommandType regs[] = {ToshibaCommandType::MODE, ToshibaCommandType::TARGET_TEMP};
+  state.expect(regs[0], 67);
+  state.expect(regs[1], 23);
+  state.sent_packed(regs, 2, NOW);
+  state.acknowledged();
+  CHECK(state.state(regs[0]) == FieldState::CONFIRMED);
+  CHECK(state.state(regs[1]) == FieldState::CONFIRMED);
+  CHECK(state.pending_count() == 0);
+}
+
+// a write of another register between the packed write and its ACK keeps the fields waiting for it
+void test_other_write_before_ack() {
+  ToshibaControlState state;
+  const ToshibaCommandType regs[] = {ToshibaCommandType::MODE, ToshibaCommandType::FAN};
+  state.expect(regs[0], 66);
+  state.expect(regs[1], 50);
+  state.sent_packed(regs, 2, NOW);
+  state.sent(ToshibaCommandType::WIFI_LED_1, NOW + 100);
+  state.acknowledged();
+  CHECK(state.state(regs[0]) == FieldState::CONFIRMED);
+  CHECK(state.state(regs[1]) == FieldState::CONFIRMED);
+  CHECK(!state.next_deadline().has_value());
+}
+
+// the ACK belongs to the last field write, earlier fields wait for their report
+void test_ack_of_later_field_write() {
+  ToshibaControlState state;
+  state.expect(ToshibaCommandType::MODE, 66);
+  state.sent(ToshibaCommandType::MODE, NOW);
+  state.expect(ToshibaCommandType::FAN, 50);
+  state.sent(ToshibaCommandType::FAN, NOW + 100);
+  state.acknowledged();
+  CHECK(state.state(ToshibaCommandType::FAN) == FieldState::CONFIRMED);
+  CHECK(state.state(ToshibaCommandType::MODE) == FieldState::PENDING);
+  CHECK(state.reported(ToshibaCommandType::MODE, 66));
+  CHECK(state.state(ToshibaCommandType::MODE) == FieldState::CONFIRMED);
+}
+
+void test_stale_report_ignored() {
+  ToshibaControlState state;
+  state.expect(ToshibaCommandType::TARGET_TEMP, 24);
+  state.sent(ToshibaCommandType::TARGET_TEMP, NOW);
+  CHECK(!state.reported(ToshibaCommandType::TARGET_TEMP, 22));
+  CHECK(state.state(ToshibaCommandType::TARGET_TEMP) == FieldState::PENDING);
+  CHECK(state.reported(ToshibaCommandType::TARGET_TEMP, 24));
+  CHECK(state.state(ToshibaCommandType::TARGET_TEMP) == FieldState::CONFIRMED);
+}
+
+void test_timeout_diverges() {
+  ToshibaControlState state;
+  state.expect(ToshibaCommandType::FAN, 50);
+  CHECK(!state.next_deadline().has_value());
+  state.sent(ToshibaCommandType::FAN, NOW);
+  CHECK(state.next_deadline() == NOW + ToshibaControlState::CONFIRM_TIMEOUT);
+  CHECK(!state.check_timeouts(NOW + ToshibaControlState::CONFIRM_TIMEOUT - 1).has_value());
+  CHECK(state.check_timeouts(NOW + ToshibaControlState::CONFIRM_TIMEOUT) == ToshibaCommandType::FAN);
+  CHECK(state.state(ToshibaCommandType::FAN) == FieldState::DIVERGED);
+  // the unit's value wins
+  CHECK(state.reported(ToshibaCommandType::FAN, 65));
+  CHECK(state.holds(ToshibaCommandType::FAN, 65));
+}
+
+void test_cancel_unsent_write() {
+  ToshibaControlState state;
+  state.expect(ToshibaCommandType::SWING, 49);
+  state.cancel(ToshibaCommandType::SWING);
+  CHECK(state.state(ToshibaCommandType::SWING) == FieldState::CONFIRMED);
+  CHECK(state.reported(ToshibaCommandType::SWING, 65));
+}
+
+}  // namespace
+
+int main() {
+  // diverged values are logged as warnings
+  host::set_log_level(ESPHOME_LOG_LEVEL_ERROR);
+  test_ack_confirms_write();
+  test_ack_confirms_packed_write();
+  test_other_write_before_ack();
+  test_ack_of_later_field_write();
+  test_stale_report_ignored();
+  test_timeout_diverges();
+  test_cancel_unsent_write();
+  if (failures != 0) {
+    fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  printf("control state: all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,486 @@
+// Daemon driving Toshiba units from Linux over serial ports or TCP, see "Linux daemon" in README.md.
+//
+// Usage:
+//   toshiba_daemon [-i poll_interval_s] [-t run_time_s] unit...
+//
+// A unit is a serial port (e.g. /dev/ttyUSB0, 9600 baud 8E1) or host:port of an RS-232-to-TCP bridge,
+// e.g. of toshiba_unit_sim. All units are driven by one epoll loop through the component's protocol core
+// (toshiba_protocol.h): handshake, paced command queue, framing and decoding of the registers.
+// Values read from the units are printed to stdout when they change. Lines "<unit> <register> <value>"
+// on stdin write a register, "<unit> <register>" reads it. On exit (SIGINT, SIGTERM or after -t) the
+// per-unit memory and CPU cost is printed to stderr as JSON.
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+#include "toshiba_protocol.h"
+
+using namespace esphome::toshiba_suzumi;
+
+namespace {
+
+// reads sent without any reply after which the link is considered lost, like the component does
+const uint8_t LINK_MISSED_REPLIES = 5;
+const uint32_t LINK_REPLY_TIMEOUT = 1000;
+const uint32_t RECONNECT_DELAY = 5000;
+// longest sleep of the event loop
+const uint32_t MAX_WAIT = 1000;
+
+const ToshibaCommandType INIT_REGISTERS[] = {
+    ToshibaCommandType::POWER_STATE, ToshibaCommandType::MODE,         ToshibaCommandType::SPECIAL_MODE,
+    ToshibaCommandType::TARGET_TEMP, ToshibaCommandType::FAN,          ToshibaCommandType::POWER_SEL,
+    ToshibaCommandType::SWING,       ToshibaCommandType::ROOM_TEMP,    ToshibaCommandType::OUTDOOR_TEMP,
+    ToshibaCommandType::IDU_STATUS,  ToshibaCommandType::ODU_STATUS,   ToshibaCommandType::ENERGY_DAILY,
+};
+const ToshibaCommandType POLL_REGISTERS[] = {
+    ToshibaCommandType::POWER_STATE, ToshibaCommandType::ROOM_TEMP,  ToshibaCommandType::OUTDOOR_TEMP,
+    ToshibaCommandType::IDU_STATUS,  ToshibaCommandType::ODU_STATUS, ToshibaCommandType::ENERGY_DAILY,
+};
+
+struct Unit {
+  const char *address;
+  bool tcp;
+  int fd;
+  // TCP connection is being established
+  bool connecting;
+  ToshibaLine line;
+  uint32_t poll_at;
+  // 0 when no reconnect is pending
+  uint32_t reconnect_at;
+  uint8_t unanswered_reads;
+  // last reported value of each register, bit N of known for register N
+  uint8_t values[256];
+  uint32_t known[8];
+  uint64_t frames_received;
+};
+
+uint32_t millis() {
+  static auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int open_tty(const char *path) {
+  int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0) {
+    return -1;
+  }
+  termios tio{};
+  if (tcgetattr(fd, &tio) != 0) {
+    close(fd);
+    return -1;
+  }
+  cfmakeraw(&tio);
+  cfsetispeed(&tio, B9600);
+  cfsetospeed(&tio, B9600);
+  // 8 data bits, even parity, 1 stop bit
+  tio.c_cflag |= CS8 | PARENB | CLOCAL | CREAD;
+  tio.c_cflag &= ~(PARODD | CSTOPB | CRTSCTS);
+  if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+    close(fd);
+    return -1;
+  }
+  tcflush(fd, TCIOFLUSH);
+  return fd;
+}
+
+// start a non-blocking connect, the socket becomes writable when it's done
+int connect_tcp(const char *address) {
+  char host[256];
+  const char *colon = strrchr(address, ':');
+  if (colon == nullptr || static_cast<size_t>(colon - address) >= sizeof(host)) {
+    return -1;
+  }
+  memcpy(host, address, colon - address);
+  host[colon - address] = '\0';
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *result;
+  if (getaddrinfo(host, colon + 1, &hints, &result) != 0) {
+    return -1;
+  }
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  if (connect(fd, result->ai_addr, result->ai_addrlen) != 0 && errno != EINPROGRESS) {
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(result);
+  return fd;
+}
+
+bool is_known(const Unit &unit, uint8_t reg) { return unit.known[reg / 32] & (1u << (reg % 32)); }
+
+bool enqueue(Unit &unit, ToshibaCommandType reg, ToshibaCommandAction action, uint8_t value, uint32_t now) {
+  if (!unit.line.enqueue(ToshibaCommand{.cmd = reg, .action = action, .value = value}, now)) {
+    fprintf(stderr, "%s: command queue is full, dropping command %u\n", unit.address, static_cast<uint8_t>(reg));
+    return false;
+  }
+  return true;
+}
+
+void start_session(Unit &unit, uint32_t now) {
+  unit.unanswered_reads = 0;
+  unit.line.reset();
+  unit.line.enqueue_handshake(now);
+  for (auto reg : INIT_REGISTERS) {
+    enqueue(unit, reg, ToshibaCommandAction::READ, 0, now);
+  }
+  unit.poll_at = now;
+}
+
+void watch(int epoll_fd, Unit &unit, size_t index) {
+  epoll_event event{};
+  event.events = unit.connecting ? EPOLLOUT : EPOLLIN;
+  event.data.u64 = index;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, unit.fd, &event);
+}
+
+void connect_unit(int epoll_fd, Unit &unit, size_t index, uint32_t now) {
+  unit.reconnect_at = 0;
+  unit.fd = unit.tcp ? connect_tcp(unit.address) : open_tty(unit.address);
+  if (unit.fd < 0) {
+    fprintf(stderr, "%s: can't open: %s, retrying in %us\n", unit.address, strerror(errno), RECONNECT_DELAY / 1000);
+    unit.reconnect_at = now + RECONNECT_DELAY;
+    return;
+  }
+  unit.connecting = unit.tcp;
+  watch(epoll_fd, unit, index);
+  if (!unit.connecting) {
+    start_session(unit, now);
+  }
+}
+
+// drop the connection and reopen it later, a serial port is kept and the handshake is repeated
+void lose_link(int epoll_fd, Unit &unit, const char *reason, uint32_t now) {
+  fprintf(stderr, "%s: %s, reconnecting in %us\n", unit.address, reason, RECONNECT_DELAY / 1000);
+  unit.line.reset();
+  if (unit.tcp && unit.fd >= 0) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, unit.fd, nullptr);
+    close(unit.fd);
+    unit.fd = -1;
+  }
+  unit.reconnect_at = now + RECONNECT_DELAY;
+}
+
+void print_value(size_t index, Unit &unit, uint8_t reg, uint8_t value) {
+  if (is_known(unit, reg) && unit.values[reg] == value) {
+    return;
+  }
+  unit.values[reg] = value;
+  unit.known[reg / 32] |= 1u << (reg % 32);
+  switch (static_cast<ToshibaCommandType>(reg)) {
+    case ToshibaCommandType::TARGET_TEMP:
+      printf("%zu %u %u\n", index, reg,
+             decode_target_temp(value, unit.values[static_cast<uint8_t>(ToshibaCommandType::SPECIAL_MODE)] ==
+                                           SPECIAL_MODE::EIGHT_DEG));
+      break;
+    case ToshibaCommandType::ROOM_TEMP:
+    case ToshibaCommandType::OUTDOOR_TEMP:
+      if (static_cast<int8_t>(value) != TEMP_UNKNOWN) {
+        printf("%zu %u %d\n", index, reg, static_cast<int8_t>(value));
+      }
+      break;
+    default:
+      printf("%zu %u %u\n", index, reg, value);
+      break;
+  }
+}
+
+void handle_frame(size_t index, Unit &unit) {
+  auto &framer = unit.line.framer();
+  auto reply = decode_reply(framer.data(), framer.length());
+  unit.frames_received++;
+  unit.unanswered_reads = 0;
+  const uint8_t *data = framer.data() + reply.data_offset;
+  switch (reply.kind) {
+    case ToshibaReplyKind::VALUE:
+      print_value(index, unit, reply.reg, reply.value);
+      break;
+    case ToshibaReplyKind::STATUS:
+      if (reply.reg == static_cast<uint8_t>(ToshibaCommandType::IDU_STATUS)) {
+        auto idu = decode_idu_status(data);
+        printf("%zu idu tc=%d tcj=%d fan_rpm=%u\n", index, idu.tc, idu.tcj, idu.fan_rpm);
+      } else if (reply.reg == static_cast<uint8_t>(ToshibaCommandType::ODU_STATUS)) {
+        auto odu = decode_odu_status(data);
+        printf("%zu odu td=%d ts=%d te=%d load_pct=%.1f iac=%u compressor=%s\n", index, odu.td, odu.ts, odu.te,
+               odu.has_load() ? odu.load_percent() : 0.0f, odu.has_iac() ? odu.iac : 0,
+               odu.compressor_running() ? "on" : "off");
+      }
+      break;
+    case ToshibaReplyKind::ENERGY: {
+      uint16_t hours[24];
+      printf("%zu energy_wh %u\n", index, decode_energy_daily(framer.data(), hours));
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void receive(int epoll_fd, size_t index, Unit &unit, uint32_t now) {
+  uint8_t buffer[256];
+  ssize_t n = read(unit.fd, buffer, sizeof(buffer));
+  if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+    lose_link(epoll_fd, unit, n == 0 ? "connection closed" : strerror(errno), now);
+    return;
+  }
+  for (ssize_t i = 0; i < n; i++) {
+    auto status = unit.line.feed(buffer[i], now);
+    if (status == ToshibaFramer::FRAME) {
+      handle_frame(index, unit);
+    } else if (status == ToshibaFramer::CHECKSUM_ERROR) {
+      fprintf(stderr, "%s: invalid checksum of a frame\n", unit.address);
+    }
+  }
+}
+
+void send_command(int epoll_fd, Unit &unit, const ToshibaCommand &command, uint32_t now) {
+  uint8_t payload[TX_BUFFER_SIZE];
+  const uint8_t *frame = payload;
+  uint8_t length;
+  switch (command.action) {
+    case ToshibaCommandAction::FRAME:
+      frame = command.frame->data;
+      length = command.frame->length;
+      break;
+    case ToshibaCommandAction::READ:
+      unit.unanswered_reads++;
+      length = build_read_frame(payload, static_cast<uint8_t>(command.cmd));
+      break;
+    case ToshibaCommandAction::WRITE:
+      length = build_write_frame(payload, static_cast<uint8_t>(command.cmd), command.value);
+      break;
+    default:
+      return;
+  }
+  if (write(unit.fd, frame, length) < 0 && errno != EAGAIN) {
+    lose_link(epoll_fd, unit, strerror(errno), now);
+  }
+}
+
+// "<unit> <register> <value>" writes the register, "<unit> <register>" reads it
+void handle_command(std::vector<Unit> &units, char *line, uint32_t now) {
+  unsigned index, reg, value;
+  int fields = sscanf(line, "%u %u %u", &index, &reg, &value);
+  if (fields < 2 || index >= units.size() || reg > 255 || (fields == 3 && value > 255)) {
+    fprintf(stderr, "Expected: <unit> <register> [value]\n");
+    return;
+  }
+  auto &unit = units[index];
+  auto cmd = static_cast<ToshibaCommandType>(reg);
+  if (fields == 2) {
+    enqueue(unit, cmd, ToshibaCommandAction::READ, 0, now);
+    return;
+  }
+  if (cmd == ToshibaCommandType::TARGET_TEMP) {
+    value = encode_target_temp(value, unit.values[static_cast<uint8_t>(ToshibaCommandType::SPECIAL_MODE)] ==
+                                          SPECIAL_MODE::EIGHT_DEG);
+  }
+  // read back, the unit reports the value it applied
+  if (enqueue(unit, cmd, ToshibaCommandAction::WRITE, value, now)) {
+    enqueue(unit, cmd, ToshibaCommandAction::READ, 0, now);
+  }
+}
+
+// run the line of the unit, returns the time until it has something to do
+uint32_t run_unit(int epoll_fd, Unit &unit, size_t index, uint32_t interval, uint32_t now) {
+  uint32_t wait = MAX_WAIT;
+  if (unit.reconnect_at != 0) {
+    if ((int32_t) (now - unit.reconnect_at) < 0) {
+      wait_until(wait, now, unit.reconnect_at);
+      return wait;
+    }
+    if (unit.fd >= 0) {
+      start_session(unit, now);
+      unit.reconnect_at = 0;
+    } else {
+      connect_unit(epoll_fd, unit, index, now);
+    }
+    return 0;
+  }
+  if (unit.fd < 0 || unit.connecting) {
+    return wait;
+  }
+  unit.line.expire_partial_frame(now);
+  if (unit.unanswered_reads >= LINK_MISSED_REPLIES && now - unit.line.last_sent() > LINK_REPLY_TIMEOUT) {
+    lose_link(epoll_fd, unit, "no reply from the unit", now);
+    return 0;
+  }
+  if ((int32_t) (now - unit.poll_at) >= 0) {
+    unit.poll_at = now + interval;
+    // skip the round when the unit doesn't keep up
+    if (unit.line.queue_size() < COMMAND_QUEUE_SIZE / 2) {
+      for (auto reg : POLL_REGISTERS) {
+        enqueue(unit, reg, ToshibaCommandAction::READ, 0, now);
+      }
+    }
+  }
+  ToshibaCommand command;
+  if (unit.line.take(now, &command)) {
+    send_command(epoll_fd, unit, command, now);
+  }
+  if (unit.unanswered_reads >= LINK_MISSED_REPLIES) {
+    wait_until(wait, now, unit.line.last_sent() + LINK_REPLY_TIMEOUT + 1);
+  }
+  wait_until(wait, now, unit.poll_at);
+  return unit.line.idle_time(now, wait);
+}
+
+void print_cost(const std::vector<Unit> &units, uint32_t run_ms) {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  double cpu_ms = usage.ru_utime.tv_sec * 1e3 + usage.ru_utime.tv_usec / 1e3 + usage.ru_stime.tv_sec * 1e3 +
+                  usage.ru_stime.tv_usec / 1e3;
+  uint64_t frames = 0;
+  for (auto &unit : units) {
+    frames += unit.frames_received;
+  }
+  double unit_hours = units.size() * (run_ms / 3600000.0);
+  fprintf(stderr,
+          "{\"units\":%zu,\"seconds\":%.1f,\"unit_bytes\":%zu,\"max_rss_kb\":%ld,\"cpu_ms_per_unit_hour\":%.2f,"
+          "\"frames_per_unit_hour\":%.0f}\n",
+          units.size(), run_ms / 1000.0, sizeof(Unit), usage.ru_maxrss, unit_hours > 0 ? cpu_ms / unit_hours : 0.0,
+          unit_hours > 0 ? frames / unit_hours : 0.0);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t interval = 60000;
+  uint32_t run_time = 0;
+  int opt;
+  bool usage = false;
+  while ((opt = getopt(argc, argv, "i:t:")) != -1) {
+    switch (opt) {
+      case 'i':
+        interval = strtoul(optarg, nullptr, 10) * 1000;
+        break;
+      case 't':
+        run_time = strtoul(optarg, nullptr, 10) * 1000;
+        break;
+      default:
+        usage = true;
+    }
+  }
+  if (usage || optind == argc || interval == 0) {
+    fprintf(stderr, "Usage: %s [-i poll_interval_s] [-t run_time_s] unit...\n", argv[0]);
+    return 2;
+  }
+
+  // the index of the unit in the event data, the signals and stdin after the units
+  std::vector<Unit> units(argc - optind);
+  size_t count = units.size();
+  int epoll_fd = epoll_create1(0);
+  uint32_t now = millis();
+  for (size_t i = 0; i < count; i++) {
+    auto &unit = units[i];
+    unit.address = argv[optind + i];
+    unit.tcp = unit.address[0] != '/';
+    unit.fd = -1;
+    connect_unit(epoll_fd, unit, i, now);
+  }
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  sigprocmask(SIG_BLOCK, &signals, nullptr);
+  // a closed connection is handled by the write error
+  signal(SIGPIPE, SIG_IGN);
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.u64 = count;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signalfd(-1, &signals, SFD_NONBLOCK), &event);
+  event.data.u64 = count + 1;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, STDIN_FILENO, &event);
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+
+  epoll_event events[16];
+  char line[128];
+  size_t line_length = 0;
+  uint32_t started = now;
+  bool running = true;
+  while (running) {
+    now = millis();
+    uint32_t wait = MAX_WAIT;
+    for (size_t i = 0; i < count; i++) {
+      uint32_t unit_wait = run_unit(epoll_fd, units[i], i, interval, now);
+      if (unit_wait < wait) {
+        wait = unit_wait;
+      }
+    }
+    if (run_time != 0) {
+      wait_until(wait, now, started + run_time);
+      if (now - started >= run_time) {
+        break;
+      }
+    }
+    int ready = epoll_wait(epoll_fd, events, 16, wait);
+    if (ready < 0 && errno != EINTR) {
+      perror("epoll_wait");
+      return 1;
+    }
+    now = millis();
+    for (int e = 0; e < ready; e++) {
+      uint64_t index = events[e].data.u64;
+      if (index == count) {
+        running = false;
+      } else if (index == count + 1) {
+        ssize_t n = read(STDIN_FILENO, line + line_length, sizeof(line) - 1 - line_length);
+        if (n <= 0) {
+          epoll_ctl(epoll_fd, EPOLL_CTL_DEL, STDIN_FILENO, nullptr);
+          continue;
+        }
+        line_length += n;
+        char *end;
+        while ((end = static_cast<char *>(memchr(line, '\n', line_length))) != nullptr) {
+          *end = '\0';
+          handle_command(units, line, now);
+          line_length -= end + 1 - line;
+          memmove(line, end + 1, line_length);
+        }
+        if (line_length == sizeof(line) - 1) {
+          line_length = 0;
+        }
+      } else {
+        auto &unit = units[index];
+        if (unit.fd < 0) {
+          continue;
+        }
+        if (unit.connecting) {
+          int error = 0;
+          socklen_t size = sizeof(error);
+          getsockopt(unit.fd, SOL_SOCKET, SO_ERROR, &error, &size);
+          if (error != 0) {
+            lose_link(epoll_fd, unit, strerror(error), now);
+            continue;
+          }
+          unit.connecting = false;
+          event.events = EPOLLIN;
+          event.data.u64 = index;
+          epoll_ctl(epoll_fd, EPOLL_CTL_MOD, unit.fd, &event);
+          fprintf(stderr, "%s: connected\n", unit.address);
+          start_session(unit, now);
+        } else {
+          receive(epoll_fd, index, unit, now);
+        }
+      }
+    }
+  }
+  print_cost(units, millis() - started);
+  return 0;
+}
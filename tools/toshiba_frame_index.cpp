@@ -0,0 +1,319 @@
+// Host tool indexing frames in UART captures of Toshiba units, see "Capture file indexer" in README.md.
+//
+// Build:
+//   g++ -O2 -std=c++17 -Icomponents/toshiba_suzumi -o toshiba_frame_index
+//       tools/toshiba_frame_index.cpp components/toshiba_suzumi/toshiba_protocol.cpp
+//
+// Usage:
+//   toshiba_frame_index [-x] [-o index.bin] capture
+//
+// The capture is raw UART bytes, or with -x hex bytes separated by whitespace, '.', ':', ',' or '-'.
+// Frames are found by the component's framing rules (0x02 header, 0x03 type, length at byte 6,
+// checksum()) and classified by decode_reply(). Per-register statistics are printed to stdout,
+// -o writes a binary index of the valid frames.
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "toshiba_protocol.h"
+
+using namespace esphome::toshiba_suzumi;
+
+namespace {
+
+// index file: header, then one record per valid frame, all little endian
+const char INDEX_MAGIC[4] = {'T', 'S', 'F', 'I'};
+const uint8_t INDEX_VERSION = 1;
+
+struct IndexRecord {
+  uint32_t offset;  // of the frame's header byte in the (decoded) capture
+  uint8_t length;
+  uint8_t reg;
+  uint8_t kind;  // ToshibaReplyKind
+  uint8_t value;
+};
+
+struct RegisterStats {
+  uint32_t frames;
+  uint32_t values;
+  uint32_t changes;
+  uint8_t last_value;
+  uint8_t min_value;
+  uint8_t max_value;
+};
+
+struct Stats {
+  uint64_t frames = 0;
+  uint64_t checksum_errors = 0;
+  uint64_t truncated = 0;
+  // start bytes not followed by a typed (0x03) frame, e.g. handshake frames or noise
+  uint64_t untyped = 0;
+  uint64_t kinds[static_cast<uint8_t>(ToshibaReplyKind::UNKNOWN) + 1] = {};
+  RegisterStats registers[256] = {};
+};
+
+const char *const KIND_NAMES[] = {"value", "ack", "time_sync_ack", "status", "energy", "unknown"};
+
+/// Bytes of the capture, memory mapped or decoded from hex.
+class Capture {
+ public:
+  ~Capture() {
+    if (this->mapped_ != nullptr) {
+      munmap(this->mapped_, this->size_);
+    }
+  }
+
+  bool open(const char *path, bool hex) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      fprintf(stderr, "Cannot stat %s: %s\n", path, strerror(errno));
+      close(fd);
+      return false;
+    }
+    this->size_ = st.st_size;
+    if (this->size_ > 0) {
+      this->mapped_ = mmap(nullptr, this->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (this->mapped_ == MAP_FAILED) {
+      this->mapped_ = nullptr;
+      fprintf(stderr, "Cannot map %s: %s\n", path, strerror(errno));
+      return false;
+    }
+    if (this->mapped_ != nullptr) {
+      madvise(this->mapped_, this->size_, MADV_SEQUENTIAL);
+    }
+    this->hex_ = hex;
+    if (!hex) {
+      return true;
+    }
+    return this->decode_hex_();
+  }
+
+  const uint8_t *data() const {
+    return this->hex_ ? this->decoded_.data() : static_cast<const uint8_t *>(this->mapped_);
+  }
+  size_t size() const { return this->hex_ ? this->decoded_.size() : this->size_; }
+
+ protected:
+  static int hex_digit_(uint8_t c) {
+    if (c >= '0' && c <= '9')
+      return c - '0';
+    if (c >= 'a' && c <= 'f')
+      return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+      return c - 'A' + 10;
+    return -1;
+  }
+
+  bool decode_hex_() {
+    auto *text = static_cast<const uint8_t *>(this->mapped_);
+    this->decoded_.reserve(this->size_ / 2);
+    int high = -1;
+    for (size_t i = 0; i < this->size_; i++) {
+      int digit = hex_digit_(text[i]);
+      if (digit >= 0) {
+        if (high < 0) {
+          high = digit;
+        } else {
+          this->decoded_.push_back(high << 4 | digit);
+          high = -1;
+        }
+      } else if (high >= 0 || strchr(" \t\r\n.:,-", text[i]) == nullptr) {
+        fprintf(stderr, "Invalid hex capture at offset %zu\n", i);
+        return false;
+      }
+    }
+    if (high >= 0) {
+      fprintf(stderr, "Invalid hex capture, odd number of digits\n");
+      return false;
+    }
+    // the mapped text is not needed anymore
+    if (this->mapped_ != nullptr) {
+      munmap(this->mapped_, this->size_);
+      this->mapped_ = nullptr;
+    }
+    return true;
+  }
+
+  void *mapped_ = nullptr;
+  size_t size_ = 0;
+  // data() and size() refer to decoded_, even when the capture decoded to no bytes
+  bool hex_ = false;
+  std::vector<uint8_t> decoded_;
+};
+
+/**
+ * Scan the capture for frames. Header bytes are located with memchr, which libc implements
+ * with vector instructions, so the bytes between frames are skipped at memory speed.
+ */
+void index_frames(const uint8_t *data, size_t size, Stats &stats, std::vector<IndexRecord> *index) {
+  const uint8_t *end = data + size;
+  const uint8_t *p = data;
+  // empty captures have no buffer at all
+  while (p < end && (p = static_cast<const uint8_t *>(memchr(p, 0x02, end - p))) != nullptr) {
+    size_t left = end - p;
+    if (left < 7 || p[2] != 0x03) {
+      if (left < 7) {
+        stats.truncated++;
+      } else {
+        stats.untyped++;
+      }
+      p++;
+      continue;
+    }
+    // prefix + data + checksum, as in ToshibaFramer
+    size_t length = 6 + p[6] + 2;
+    if (length > RX_BUFFER_SIZE) {
+      stats.untyped++;
+      p++;
+      continue;
+    }
+    if (length > left) {
+      stats.truncated++;
+      p++;
+      continue;
+    }
+    if (p[length - 1] != checksum(p, length - 1)) {
+      stats.checksum_errors++;
+      p++;
+      continue;
+    }
+    auto reply = decode_reply(p, length);
+    stats.frames++;
+    stats.kinds[static_cast<uint8_t>(reply.kind)]++;
+    if (reply.kind != ToshibaReplyKind::ACK && reply.kind != ToshibaReplyKind::TIME_SYNC_ACK &&
+        reply.kind != ToshibaReplyKind::UNKNOWN) {
+      auto &reg = stats.registers[reply.reg];
+      if (reply.kind == ToshibaReplyKind::VALUE) {
+        if (reg.values == 0) {
+          reg.min_value = reg.max_value = reply.value;
+        } else {
+          reg.changes += reply.value != reg.last_value;
+          reg.min_value = reply.value < reg.min_value ? reply.value : reg.min_value;
+          reg.max_value = reply.value > reg.max_value ? reply.value : reg.max_value;
+        }
+        reg.last_value = reply.value;
+        reg.values++;
+      }
+      reg.frames++;
+    }
+    if (index != nullptr) {
+      index->push_back(IndexRecord{static_cast<uint32_t>(p - data), static_cast<uint8_t>(length), reply.reg,
+                                   static_cast<uint8_t>(reply.kind), reply.value});
+    }
+    p += length;
+  }
+}
+
+void put_u32(uint8_t *out, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    out[i] = value >> (8 * i);
+  }
+}
+
+bool write_index(const char *path, const std::vector<IndexRecord> &index) {
+  FILE *f = fopen(path, "wb");
+  if (f == nullptr) {
+    fprintf(stderr, "Cannot create %s: %s\n", path, strerror(errno));
+    return false;
+  }
+  uint8_t header[9];
+  memcpy(header, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  header[4] = INDEX_VERSION;
+  put_u32(header + 5, index.size());
+  bool ok = fwrite(header, sizeof(header), 1, f) == 1;
+  std::vector<uint8_t> records(index.size() * 8);
+  for (size_t i = 0; i < index.size(); i++) {
+    uint8_t *record = &records[i * 8];
+    put_u32(record, index[i].offset);
+    record[4] = index[i].length;
+    record[5] = index[i].reg;
+    record[6] = index[i].kind;
+    record[7] = index[i].value;
+  }
+  ok = ok && (records.empty() || fwrite(records.data(), records.size(), 1, f) == 1);
+  ok = fclose(f) == 0 && ok;
+  if (!ok) {
+    fprintf(stderr, "Cannot write %s\n", path);
+  }
+  return ok;
+}
+
+void print_stats(const Stats &stats, size_t size) {
+  printf("bytes: %zu\n", size);
+  printf("frames: %llu\n", (unsigned long long) stats.frames);
+  for (uint8_t i = 0; i <= static_cast<uint8_t>(ToshibaReplyKind::UNKNOWN); i++) {
+    printf("  %s: %llu\n", KIND_NAMES[i], (unsigned long long) stats.kinds[i]);
+  }
+  printf("checksum errors: %llu\n", (unsigned long long) stats.checksum_errors);
+  printf("truncated: %llu\n", (unsigned long long) stats.truncated);
+  printf("untyped: %llu\n", (unsigned long long) stats.untyped);
+  printf("register,frames,values,changes,min,max,last\n");
+  for (int reg = 0; reg < 256; reg++) {
+    auto &r = stats.registers[reg];
+    if (r.frames == 0) {
+      continue;
+    }
+    if (r.values == 0) {
+      printf("%d,%u,0,0,,,\n", reg, r.frames);
+    } else {
+      printf("%d,%u,%u,%u,%u,%u,%u\n", reg, r.frames, r.values, r.changes, r.min_value, r.max_value, r.last_value);
+    }
+  }
+}
+
+void usage(const char *name) { fprintf(stderr, "Usage: %s [-x] [-o index.bin] capture\n", name); }
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool hex = false;
+  const char *index_path = nullptr;
+  int opt;
+  while ((opt = getopt(argc, argv, "xo:")) != -1) {
+    switch (opt) {
+      case 'x':
+        hex = true;
+        break;
+      case 'o':
+        index_path = optarg;
+        break;
+      default:
+        usage(argv[0]);
+        return 2;
+    }
+  }
+  if (optind != argc - 1) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  Capture capture;
+  if (!capture.open(argv[optind], hex)) {
+    return 1;
+  }
+  if (index_path != nullptr && capture.size() > UINT32_MAX) {
+    fprintf(stderr, "Capture is too large for the index, split it into files below 4 GiB\n");
+    return 1;
+  }
+  Stats stats;
+  std::vector<IndexRecord> index;
+  index_frames(capture.data(), capture.size(), stats, index_path != nullptr ? &index : nullptr);
+  print_stats(stats, capture.size());
+  if (index_path != nullptr && !write_index(index_path, index)) {
+    return 1;
+  }
+  return 0;
+}
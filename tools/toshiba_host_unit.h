@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdio>
+#include "host.h"
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/components/time/real_time_clock.h"
+#include "esphome/components/uart/uart.h"
+#include "toshiba_climate.h"
+#include "toshiba_sim.h"
+
+/**
+ * A unit of the host node: the component with all its sensors, connected to a simulated unit
+ * through UART on the virtual clock. Shared by the host tools, see "Host tools" in README.md.
+ */
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+/// UART between the component and the simulated unit.
+class ToshibaSimUart : public uart::UARTComponent {
+ public:
+  explicit ToshibaSimUart(ToshibaUnitSim *sim) : sim_(sim) {}
+
+  void write_array(const uint8_t *data, size_t len) override { this->sim_->receive(data, len, host::now_us()); }
+  int available() override { return this->sim_->available(host::now_us()); }
+  bool read_array(uint8_t *data, size_t len) override { return this->sim_->read(data, len, host::now_us()) == len; }
+
+ protected:
+  ToshibaUnitSim *sim_;
+};
+
+struct ToshibaHostUnit {
+  // 2026-01-15 10:00:00 UTC, the clock of all units
+  static const time_t EPOCH = 1768471200;
+
+  ToshibaHostUnit(uint8_t index, const ToshibaUnitSim::Config &config, time::RealTimeClock *clock,
+                  uint32_t update_interval)
+      : sim(config), uart(&sim) {
+    snprintf(this->name, sizeof(this->name), "unit_%u", index);
+    this->climate.set_name(this->name);
+    this->climate.set_uart_parent(&this->uart);
+    this->climate.set_update_interval(update_interval);
+    this->climate.set_time(clock);
+    this->climate.set_indoor_temp_sensor(&this->indoor_temp);
+    this->climate.set_outdoor_temp_sensor(&this->outdoor_temp);
+    this->climate.set_energy_sensor(&this->energy);
+    this->climate.set_power_sensor(&this->power);
+    this->climate.set_lifetime_energy_sensor(&this->lifetime_energy);
+    this->climate.set_cdu_td_temp_sensor(&this->cdu_td_temp);
+    this->climate.set_cdu_load_sensor(&this->cdu_load);
+    this->climate.set_cdu_iac_sensor(&this->cdu_iac);
+    this->climate.set_fcu_tc_temp_sensor(&this->fcu_tc_temp);
+    this->climate.set_fcu_fan_rpm_sensor(&this->fcu_fan_rpm);
+    this->climate.set_self_clean_sensor(&this->self_clean);
+    this->climate.set_connected_sensor(&this->connected);
+    host::register_component(&this->climate);
+  }
+
+  char name[16];
+  ToshibaUnitSim sim;
+  ToshibaSimUart uart;
+  ToshibaClimateUart climate;
+  sensor::Sensor indoor_temp;
+  sensor::Sensor outdoor_temp;
+  sensor::Sensor energy;
+  sensor::Sensor power;
+  sensor::Sensor lifetime_energy;
+  sensor::Sensor cdu_td_temp;
+  sensor::Sensor cdu_load;
+  sensor::Sensor cdu_iac;
+  sensor::Sensor fcu_tc_temp;
+  sensor::Sensor fcu_fan_rpm;
+  binary_sensor::BinarySensor self_clean;
+  binary_sensor::BinarySensor connected;
+};
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
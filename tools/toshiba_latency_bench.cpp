@@ -0,0 +1,250 @@
+// Latency of control() against a simulated unit, see "Host tools" in README.md.
+//
+// Usage:
+//   toshiba_latency_bench [-c controls] [-d reply_delay_ms] [-i loop_interval_ms] [-l load] [-s seed]
+//                         [-b baseline.json] [-t threshold_pct] [-v]
+//
+// One unit heats on the virtual clock. Every few seconds (random, -s seeds it) the target temperature or
+// the fan mode is changed through a climate call. For each call two times are measured:
+//   to_wire       from the call until the write frame starts on the line
+//   to_confirmed  from the call until the unit confirmed the value (the field is CONFIRMED again)
+// The load is a comma separated list of what runs besides the calls, all of it by default:
+//   poll    polling every 30 s        energy  energy sync by demand
+//   time    time sync every minute    scan    register scan running all the time
+// or "none". Prints one JSON object with p50, p99 and max of both times in ms.
+//
+// With -b the result is compared to a baseline printed by an earlier run: the exit code is 1 when p50 or
+// p99 of a time is worse by more than the threshold (default 10 %). Runs are deterministic for a seed.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "toshiba_host_unit.h"
+
+using namespace esphome;
+using namespace esphome::toshiba_suzumi;
+
+namespace {
+
+// a call which isn't confirmed by then is counted as a timeout
+const uint32_t CONFIRM_LIMIT_MS = 10000;
+
+struct Percentiles {
+  double p50;
+  double p99;
+  double max;
+};
+
+Percentiles percentiles(std::vector<double> samples) {
+  if (samples.empty()) {
+    return {0, 0, 0};
+  }
+  std::sort(samples.begin(), samples.end());
+  // nearest rank
+  auto rank = [&samples](double p) { return samples[std::max<size_t>(1, p * samples.size() + 0.999999) - 1]; };
+  return {rank(0.5), rank(0.99), samples.back()};
+}
+
+// The value of "key": {"p50": ...} in the baseline, -1 when missing.
+double baseline_value(const std::string &json, const char *key, const char *field) {
+  size_t at = json.find(std::string("\"") + key + "\"");
+  if (at == std::string::npos) {
+    return -1;
+  }
+  at = json.find(std::string("\"") + field + "\":", at);
+  if (at == std::string::npos) {
+    return -1;
+  }
+  return strtod(json.c_str() + at + strlen(field) + 3, nullptr);
+}
+
+bool has_load(const char *load, const char *name) {
+  std::string list = std::string(",") + load + ",";
+  return list.find(std::string(",") + name + ",") != std::string::npos;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t controls = 200;
+  uint32_t loop_interval = 16;
+  uint32_t seed = 1;
+  const char *load = "poll,energy,time,scan";
+  const char *baseline = nullptr;
+  double threshold = 10;
+  bool verbose = false;
+  ToshibaUnitSim::Config config;
+  int opt;
+  while ((opt = getopt(argc, argv, "c:d:i:l:s:b:t:v")) != -1) {
+    switch (opt) {
+      case 'c':
+        controls = strtoul(optarg, nullptr, 10);
+        break;
+      case 'd':
+        config.reply_delay_us = strtoul(optarg, nullptr, 10) * 1000;
+        break;
+      case 'i':
+        loop_interval = strtoul(optarg, nullptr, 10);
+        break;
+      case 'l':
+        load = optarg;
+        break;
+      case 's':
+        seed = strtoul(optarg, nullptr, 10);
+        break;
+      case 'b':
+        baseline = optarg;
+        break;
+      case 't':
+        threshold = strtod(optarg, nullptr);
+        break;
+      case 'v':
+        verbose = true;
+        break;
+      default:
+        controls = 0;
+    }
+  }
+  if (controls == 0 || loop_interval == 0) {
+    fprintf(stderr,
+            "Usage: %s [-c controls] [-d reply_delay_ms] [-i loop_interval_ms] [-l load] [-s seed] "
+            "[-b baseline.json] [-t threshold_pct] [-v]\n",
+            argv[0]);
+    return 2;
+  }
+
+  // scan() reports each unknown register as a warning
+  host::set_log_level(verbose ? ESPHOME_LOG_LEVEL_DEBUG : ESPHOME_LOG_LEVEL_ERROR);
+  host::set_loop_interval(loop_interval);
+  time::RealTimeClock clock;
+  clock.set_epoch(ToshibaHostUnit::EPOCH);
+  ToshibaHostUnit unit(0, config, &clock, has_load(load, "poll") ? 30000 : 86400000);
+  if (!has_load(load, "energy")) {
+    unit.climate.set_energy_sensor(nullptr);
+    unit.climate.set_power_sensor(nullptr);
+    unit.climate.set_lifetime_energy_sensor(nullptr);
+  }
+  if (has_load(load, "time")) {
+    unit.climate.set_time_sync_interval(60000);
+  } else {
+    unit.climate.set_time(nullptr);
+  }
+  bool scan = has_load(load, "scan");
+
+  host::setup();
+  host::run_for(UNIT_SETUP_STAGGER + 10000);
+  auto heat = unit.climate.make_call();
+  heat.set_mode(climate::CLIMATE_MODE_HEAT).set_target_temperature(22);
+  heat.perform();
+  host::run_for(10000);
+
+  static const climate::ClimateFanMode FAN_MODES[] = {climate::CLIMATE_FAN_AUTO, climate::CLIMATE_FAN_LOW,
+                                                      climate::CLIMATE_FAN_MEDIUM, climate::CLIMATE_FAN_HIGH,
+                                                      climate::CLIMATE_FAN_QUIET};
+  std::mt19937 random(seed);
+  std::vector<double> to_wire;
+  std::vector<double> to_confirmed;
+  uint32_t timeouts = 0;
+  uint32_t next_scan = 0;
+  for (uint32_t i = 0; i < controls; i++) {
+    uint32_t idle = 2000 + random() % 8000;
+    host::run_for(idle);
+    if (scan && next_scan <= idle) {
+      // a scan takes about 13 s, restarting it keeps one running
+      unit.climate.scan();
+      next_scan = 15000;
+    } else if (scan) {
+      next_scan -= idle;
+    }
+
+    auto call = unit.climate.make_call();
+    uint8_t reg;
+    if (random() % 2 == 0) {
+      reg = ToshibaUnitSim::TARGET_TEMP;
+      float target = unit.climate.target_temperature;
+      call.set_target_temperature(target >= 25 ? 21 : target + 1);
+    } else {
+      reg = ToshibaUnitSim::FAN;
+      auto fan_mode = unit.climate.fan_mode.value_or(climate::CLIMATE_FAN_AUTO);
+      auto *current = std::find(std::begin(FAN_MODES), std::end(FAN_MODES), fan_mode);
+      auto *next = current + 1 >= std::end(FAN_MODES) ? std::begin(FAN_MODES) : current + 1;
+      call.set_fan_mode(*next);
+    }
+    uint32_t writes = unit.sim.write_count(reg);
+    uint64_t start = host::now_us();
+    call.perform();
+
+    bool wired = false;
+    bool done = false;
+    while (host::now_us() - start < CONFIRM_LIMIT_MS * 1000ull) {
+      host::run_for(loop_interval);
+      if (!wired && unit.sim.write_count(reg) != writes) {
+        wired = true;
+        to_wire.push_back((unit.sim.last_write_us(reg) - start) / 1000.0);
+      }
+      if (wired && unit.climate.get_control_state().state(static_cast<ToshibaCommandType>(reg)) ==
+                       FieldState::CONFIRMED) {
+        to_confirmed.push_back((host::now_us() - start) / 1000.0);
+        if (verbose) {
+          ESP_LOGD("bench", "Register %u confirmed after %.0f ms", reg, to_confirmed.back());
+        }
+        done = true;
+        break;
+      }
+    }
+    if (!done) {
+      timeouts++;
+    }
+  }
+
+  auto wire = percentiles(to_wire);
+  auto confirmed = percentiles(to_confirmed);
+  printf("{\"controls\":%u,\"reply_delay_ms\":%u,\"loop_interval_ms\":%u,\"load\":\"%s\",\"seed\":%u,"
+         "\"to_wire_ms\":{\"p50\":%.1f,\"p99\":%.1f,\"max\":%.1f},"
+         "\"to_confirmed_ms\":{\"p50\":%.1f,\"p99\":%.1f,\"max\":%.1f},\"timeouts\":%u}\n",
+         controls, config.reply_delay_us / 1000, loop_interval, load, seed, wire.p50, wire.p99, wire.max,
+         confirmed.p50, confirmed.p99, confirmed.max, timeouts);
+
+  if (baseline == nullptr) {
+    return timeouts == 0 ? 0 : 1;
+  }
+  FILE *file = fopen(baseline, "r");
+  if (file == nullptr) {
+    perror(baseline);
+    return 2;
+  }
+  std::string json;
+  char buffer[512];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    json.append(buffer, n);
+  }
+  fclose(file);
+
+  bool regressed = timeouts != 0;
+  const struct {
+    const char *key;
+    const char *field;
+    double value;
+  } checks[] = {{"to_wire_ms", "p50", wire.p50},
+                {"to_wire_ms", "p99", wire.p99},
+                {"to_confirmed_ms", "p50", confirmed.p50},
+                {"to_confirmed_ms", "p99", confirmed.p99}};
+  for (const auto &check : checks) {
+    double base = baseline_value(json, check.key, check.field);
+    if (base < 0) {
+      fprintf(stderr, "%s: no %s.%s\n", baseline, check.key, check.field);
+      return 2;
+    }
+    bool worse = check.value > base * (1 + threshold / 100);
+    fprintf(stderr, "%s.%s: %.1f ms, baseline %.1f ms%s\n", check.key, check.field, check.value, base,
+            worse ? " - REGRESSION" : "");
+    regressed |= worse;
+  }
+  return regressed ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+// Stress test of the lock-free ring handing bytes from the RX task to the main loop, see "Host tools" in README.md.
+//
+// Usage:
+//   toshiba_ring_stress [megabytes]
+//
+// A producer thread pushes a pseudo-random byte stream in chunks of random length, as the RX task does
+// with the bytes read from UART, a consumer thread pops chunks of random length and checks that every
+// byte arrives once and in order. Rings of several sizes are tested, the small ones wrap on nearly every
+// push. The indexes wrap at 2^16 many times during each run. Exits with 1 on the first corrupted byte.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include "toshiba_spsc_ring.h"
+
+using namespace esphome::toshiba_suzumi;
+
+namespace {
+
+// xorshift, one generator per thread
+struct Random {
+  uint32_t state;
+  uint32_t next() {
+    this->state ^= this->state << 13;
+    this->state ^= this->state >> 17;
+    this->state ^= this->state << 5;
+    return this->state;
+  }
+};
+
+// byte number i of the stream, a sequence number alone would hide reordering by multiples of 256
+uint8_t stream_byte(uint64_t i) { return (i * 2654435761u) >> 24 ^ i; }
+
+template<uint16_t N> bool stress(uint64_t total) {
+  static SpscRing<N> ring;
+  std::atomic<bool> failed{false};
+  auto start = std::chrono::steady_clock::now();
+
+  std::thread producer([&]() {
+    Random random{0x12345678};
+    uint8_t chunk[64];
+    uint64_t sent = 0;
+    while (sent < total && !failed.load(std::memory_order_relaxed)) {
+      uint16_t length = 1 + random.next() % sizeof(chunk);
+      if (length > total - sent) {
+        length = total - sent;
+      }
+      for (uint16_t i = 0; i < length; i++) {
+        chunk[i] = stream_byte(sent + i);
+      }
+      // the RX task drops what doesn't fit, here the rest is pushed again to keep the stream verifiable
+      uint16_t stored = 0;
+      while (stored < length && !failed.load(std::memory_order_relaxed)) {
+        uint16_t pushed = ring.push(chunk + stored, length - stored);
+        if (pushed == 0) {
+          std::this_thread::yield();
+        }
+        stored += pushed;
+      }
+      sent += length;
+    }
+  });
+
+  Random random{0x9abcdef0};
+  uint8_t chunk[128];
+  uint64_t received = 0;
+  while (received < total) {
+    uint16_t length = ring.pop(chunk, 1 + random.next() % sizeof(chunk));
+    if (length == 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+      if (chunk[i] != stream_byte(received + i)) {
+        fprintf(stderr, "ring %u: byte %llu is %02X, expected %02X\n", N, (unsigned long long) (received + i),
+                chunk[i], stream_byte(received + i));
+        failed = true;
+        producer.join();
+        return false;
+      }
+    }
+    received += length;
+  }
+  producer.join();
+  if (ring.size() != 0) {
+    fprintf(stderr, "ring %u: %u bytes left after the stream ended\n", N, ring.size());
+    return false;
+  }
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("ring %5u: %llu bytes in %.2fs, %.1f MB/s\n", N, (unsigned long long) total, seconds,
+         total / seconds / 1e6);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint64_t megabytes = argc > 1 ? strtoull(argv[1], nullptr, 10) : 16;
+  if (megabytes == 0) {
+    fprintf(stderr, "Usage: %s [megabytes]\n", argv[0]);
+    return 2;
+  }
+  uint64_t total = megabytes << 20;
+  // the size used by the RX task, and rings which wrap with nearly every chunk
+  bool ok = stress<512>(total) && stress<64>(total / 4) && stress<2>(total / 16) && stress<32768>(total);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+#include "toshiba_sim.h"
+#include <cstring>
+#include "toshiba_protocol.h"
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+// header of the unit's frames, byte 6 (length) and 11 (data size) are filled in
+static const uint8_t REPLY_PREFIX[] = {2, 0, 3, 0x90, 0, 0, 0, 1, 0x30, 1, 0, 0};
+static const uint8_t TIME_SYNC_LENGTH = 0xef;
+static const uint8_t TIME_SYNC_MARK = 0x99;
+static const uint8_t POWER_OFF = 49;
+
+ToshibaUnitSim::ToshibaUnitSim(const Config &config) : config_(config) {
+  static const uint8_t DEFAULTS[][2] = {
+      {POWER_STATE, POWER_OFF}, {POWER_SEL, 100}, {148, 66},    {FAN, 65},      {SWING, 49},
+      {MODE, 66},               {TARGET_TEMP, 22}, {ROOM_TEMP, 23}, {OUTDOOR_TEMP, 12}, {SELF_CLEAN, 0x10},
+      {WIFI_LED_1, 0},          {WIFI_LED_2, 0},  {SPECIAL_MODE, 0},
+  };
+  for (auto &reg : DEFAULTS) {
+    this->values_[reg[0]] = reg[1];
+    this->set_supported(reg[0], true);
+  }
+  this->set_supported(ENERGY_DAILY, true);
+  this->set_supported(IDU_STATUS, true);
+  this->set_supported(ODU_STATUS, true);
+}
+
+void ToshibaUnitSim::set_supported(uint8_t reg, bool supported) {
+  if (supported) {
+    this->supported_[reg / 32] |= 1u << (reg % 32);
+  } else {
+    this->supported_[reg / 32] &= ~(1u << (reg % 32));
+  }
+}
+
+/**
+ * The bytes arrive one by one at the baud rate, frames are handled when their last byte arrived.
+ * Frames of the handshake don't carry a length, they are matched against the known ones.
+ */
+void ToshibaUnitSim::receive(const uint8_t *data, size_t length, uint64_t now_us) {
+  this->advance_(now_us);
+  for (size_t i = 0; i < length; i++) {
+    uint64_t arrival = now_us + (i + 1) * this->byte_us_();
+    this->stats_.bytes_received++;
+    if (this->rx_length_ == 0) {
+      if (data[i] != 0x02) {
+        continue;
+      }
+      this->rx_start_us_ = now_us + i * this->byte_us_();
+    }
+    this->rx_[this->rx_length_++] = data[i];
+    if (this->rx_length_ < 3) {
+      continue;
+    }
+    if (this->rx_[2] != 0x03) {
+      if (this->handle_handshake_byte_()) {
+        this->stats_.handshake_frames++;
+        this->rx_length_ = 0;
+      }
+      continue;
+    }
+    if (this->rx_length_ > 6 && this->rx_length_ == this->rx_[6] + 8) {
+      this->handle_frame_(arrival);
+      this->rx_length_ = 0;
+    } else if (this->rx_length_ == RX_MAX) {
+      this->rx_length_ = 0;
+    }
+  }
+}
+
+/// Returns true when a complete handshake frame was received, drops bytes which don't start one.
+bool ToshibaUnitSim::handle_handshake_byte_() {
+  bool prefix = false;
+  const ToshibaFrame *tables[] = {HANDSHAKE, AFTER_HANDSHAKE};
+  const uint8_t sizes[] = {HANDSHAKE_FRAMES, AFTER_HANDSHAKE_FRAMES};
+  for (uint8_t t = 0; t < 2; t++) {
+    for (uint8_t i = 0; i < sizes[t]; i++) {
+      auto &frame = tables[t][i];
+      if (frame.length >= this->rx_length_ && memcmp(frame.data, this->rx_, this->rx_length_) == 0) {
+        if (frame.length == this->rx_length_) {
+          return true;
+        }
+        prefix = true;
+      }
+    }
+  }
+  if (!prefix) {
+    this->rx_length_ = 0;
+  }
+  return false;
+}
+
+void ToshibaUnitSim::handle_frame_(uint64_t end_us) {
+  uint8_t length = this->rx_length_;
+  auto *data = this->rx_;
+  if (data[length - 1] != checksum(data, length - 1)) {
+    this->stats_.checksum_errors++;
+    return;
+  }
+  this->stats_.frames_received++;
+  uint64_t reply_at = end_us + this->config_.reply_delay_us;
+
+  if (data[6] == TIME_SYNC_LENGTH && data[12] == TIME_SYNC_MARK) {
+    this->stats_.time_syncs++;
+    this->clock_seconds_ = data[16] * 3600 + data[17] * 60 + data[18];
+    this->clock_set_us_ = end_us;
+    this->reply_ack_(true, reply_at);
+    return;
+  }
+  uint8_t size = data[11];
+  if (size == 1) {
+    uint8_t reg = data[12];
+    this->stats_.reads++;
+    if (!this->is_supported(reg)) {
+      this->stats_.unanswered_reads++;
+    } else if (reg == ENERGY_DAILY) {
+      this->reply_energy_(reply_at);
+    } else if (reg == IDU_STATUS || reg == ODU_STATUS) {
+      this->reply_status_(reg, reply_at);
+    } else {
+      this->reply_value_(reg, reply_at);
+    }
+    return;
+  }
+  uint8_t count = size / 2;
+  if (count == 0 || 12 + size + 1 != length) {
+    return;
+  }
+  if (count > 1 && !this->config_.packed_writes) {
+    this->stats_.rejected_writes++;
+    return;
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t reg = data[12 + 2 * i];
+    this->values_[reg] = data[13 + 2 * i];
+    this->last_write_us_[reg] = this->rx_start_us_;
+    this->write_count_[reg]++;
+  }
+  this->stats_.writes++;
+  this->reply_ack_(false, reply_at);
+}
+
+void ToshibaUnitSim::set_register(uint8_t reg, uint8_t value, bool push, uint64_t now_us) {
+  this->advance_(now_us);
+  this->values_[reg] = value;
+  if (push) {
+    this->stats_.pushes++;
+    this->reply_value_(reg, now_us);
+  }
+}
+
+void ToshibaUnitSim::reply_value_(uint8_t reg, uint64_t at_us) {
+  uint8_t frame[15];
+  memcpy(frame, REPLY_PREFIX, sizeof(REPLY_PREFIX));
+  frame[6] = sizeof(frame) - 8;
+  frame[11] = 2;
+  frame[12] = reg;
+  frame[13] = this->values_[reg];
+  frame[14] = checksum(frame, 14);
+  this->send_(frame, sizeof(frame), at_us);
+}
+
+void ToshibaUnitSim::reply_ack_(bool time_sync, uint64_t at_us) {
+  uint8_t frame[16];
+  memcpy(frame, REPLY_PREFIX, sizeof(REPLY_PREFIX));
+  frame[6] = sizeof(frame) - 8;
+  frame[11] = 3;
+  frame[12] = 0;
+  frame[13] = time_sync ? TIME_SYNC_MARK : 0;
+  frame[14] = time_sync ? TIME_SYNC_MARK : 0;
+  frame[15] = checksum(frame, 15);
+  this->send_(frame, sizeof(frame), at_us);
+}
+
+/// 24 bytes long IDU/ODU status, the data starts at byte 15.
+void ToshibaUnitSim::reply_status_(uint8_t reg, uint64_t at_us) {
+  bool on = this->values_[POWER_STATE] == POWER_ON;
+  uint8_t frame[24];
+  memcpy(frame, REPLY_PREFIX, sizeof(REPLY_PREFIX));
+  frame[6] = sizeof(frame) - 8;
+  frame[11] = 10;
+  frame[12] = 0;
+  frame[13] = 0;
+  frame[14] = reg;
+  memset(frame + 15, 127, 8);
+  if (reg == IDU_STATUS) {
+    frame[15] = on ? 35 : this->values_[ROOM_TEMP];  // Tc
+    frame[16] = on ? 33 : this->values_[ROOM_TEMP];  // Tcj
+    frame[17] = on ? 40 + (this->values_[FAN] & 0x0F) : 0;  // fan
+  } else {
+    frame[15] = on ? 60 : this->values_[OUTDOOR_TEMP];  // Td
+    frame[16] = on ? 10 : this->values_[OUTDOOR_TEMP];  // Ts
+    frame[17] = on ? 5 : this->values_[OUTDOOR_TEMP];   // Te
+    frame[18] = on ? 85 : 0;                            // load
+    frame[19] = 0;
+    frame[20] = 0;
+    frame[21] = on ? 30 : 0;  // IAC
+  }
+  frame[23] = checksum(frame, 23);
+  this->send_(frame, sizeof(frame), at_us);
+}
+
+/// 70 bytes long daily energy, Wh of the hours of the day from byte 21, little endian.
+void ToshibaUnitSim::reply_energy_(uint64_t at_us) {
+  uint8_t frame[70];
+  memcpy(frame, REPLY_PREFIX, sizeof(REPLY_PREFIX));
+  memset(frame + sizeof(REPLY_PREFIX), 0, sizeof(frame) - sizeof(REPLY_PREFIX));
+  frame[6] = sizeof(frame) - 8;
+  frame[11] = 56;
+  frame[14] = ENERGY_DAILY;
+  for (uint8_t i = 0; i < 24; i++) {
+    uint16_t wh = this->energy_wh_[i];
+    frame[21 + i * 2] = wh & 0xFF;
+    frame[21 + i * 2 + 1] = wh >> 8;
+  }
+  frame[69] = checksum(frame, 69);
+  this->send_(frame, sizeof(frame), at_us);
+}
+
+/// Queue the frame behind the frames still on the line.
+void ToshibaUnitSim::send_(const uint8_t *data, uint8_t length, uint64_t at_us) {
+  if (this->tx_count_ == TX_FRAMES) {
+    this->stats_.dropped_replies++;
+    return;
+  }
+  auto &frame = this->tx_[(this->tx_head_ + this->tx_count_) % TX_FRAMES];
+  memcpy(frame.data, data, length);
+  frame.length = length;
+  frame.read = 0;
+  frame.start_us = at_us > this->tx_free_us_ ? at_us : this->tx_free_us_;
+  this->tx_free_us_ = frame.start_us + length * this->byte_us_();
+  this->tx_count_++;
+  this->stats_.bytes_sent += length;
+}
+
+size_t ToshibaUnitSim::available(uint64_t now_us) {
+  this->advance_(now_us);
+  size_t available = 0;
+  for (uint8_t i = 0; i < this->tx_count_; i++) {
+    auto &frame = this->tx_[(this->tx_head_ + i) % TX_FRAMES];
+    if (now_us < frame.start_us) {
+      break;
+    }
+    uint64_t arrived = (now_us - frame.start_us) / this->byte_us_();
+    if (arrived < frame.length) {
+      available += arrived - frame.read;
+      break;
+    }
+    available += frame.length - frame.read;
+  }
+  return available;
+}
+
+size_t ToshibaUnitSim::read(uint8_t *data, size_t length, uint64_t now_us) {
+  size_t available = this->available(now_us);
+  if (length > available) {
+    length = available;
+  }
+  size_t done = 0;
+  while (done < length) {
+    auto &frame = this->tx_[this->tx_head_];
+    size_t chunk = frame.length - frame.read;
+    if (chunk > length - done) {
+      chunk = length - done;
+    }
+    memcpy(data + done, frame.data + frame.read, chunk);
+    frame.read += chunk;
+    done += chunk;
+    if (frame.read == frame.length) {
+      this->tx_head_ = (this->tx_head_ + 1) % TX_FRAMES;
+      this->tx_count_--;
+    }
+  }
+  return done;
+}
+
+uint64_t ToshibaUnitSim::next_event_us(uint64_t now_us) {
+  this->advance_(now_us);
+  uint64_t next = this->config_.status_interval_ms != 0 ? this->next_push_us_ : 0;
+  if (this->tx_count_ != 0) {
+    auto &frame = this->tx_[this->tx_head_];
+    uint64_t byte = frame.start_us + (frame.read + 1) * this->byte_us_();
+    if (next == 0 || byte < next) {
+      next = byte;
+    }
+  }
+  return next;
+}
+
+uint8_t ToshibaUnitSim::hour_(uint64_t now_us) const {
+  return (this->clock_seconds_ + (now_us - this->clock_set_us_) / 1000000) / 3600 % 24;
+}
+
+/// Count the energy consumed and push the status up to now.
+void ToshibaUnitSim::advance_(uint64_t now_us) {
+  if (now_us <= this->advanced_us_) {
+    return;
+  }
+  uint8_t hour = this->hour_(now_us);
+  if (hour != this->energy_hour_) {
+    if (hour < this->energy_hour_) {
+      // new day
+      memset(this->energy_wh_, 0, sizeof(this->energy_wh_));
+    }
+    this->energy_hour_ = hour;
+  }
+  if (this->values_[POWER_STATE] == POWER_ON) {
+    this->energy_wh_[hour] += this->config_.power_watts * (now_us - this->advanced_us_) / 3.6e9;
+  }
+  this->advanced_us_ = now_us;
+
+  if (this->config_.status_interval_ms == 0) {
+    return;
+  }
+  uint64_t interval = this->config_.status_interval_ms * 1000ull;
+  if (this->next_push_us_ == 0) {
+    this->next_push_us_ = now_us + interval;
+  }
+  while (this->next_push_us_ <= now_us) {
+    this->stats_.pushes += 2;
+    this->reply_status_(IDU_STATUS, this->next_push_us_);
+    this->reply_status_(ODU_STATUS, this->next_push_us_);
+    this->next_push_us_ += interval;
+  }
+}
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
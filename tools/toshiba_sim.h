@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Simulated Toshiba unit speaking the serial protocol of toshiba_protocol.h, see "Host tools" in README.md.
+ * Free of ESPHome includes: it is driven by the host build of the component (toshiba_host_unit.h) as well
+ * as by the TCP server of toshiba_unit_sim.
+ *
+ * The unit answers reads of the registers it supports and acknowledges writes. Unsupported registers stay
+ * unanswered. Bytes travel at the configured baud rate and the unit starts to reply after the reply delay.
+ * IDU and ODU status is pushed periodically and the daily energy grows while the unit is on.
+ * All times are passed in by the caller, so the unit runs on a virtual clock as well as on a real one.
+ */
+
+namespace esphome {
+namespace toshiba_suzumi {
+
+class ToshibaUnitSim {
+ public:
+  struct Config {
+    // from the end of a request to the first byte of the reply
+    uint32_t reply_delay_us = 20000;
+    uint32_t baud = 9600;
+    // IDU and ODU status push period, 0 disables the pushes
+    uint32_t status_interval_ms = 60000;
+    // the unit acknowledges writes of several registers in one frame
+    bool packed_writes = true;
+    // consumption while the unit is on
+    uint32_t power_watts = 900;
+  };
+
+  struct Stats {
+    uint32_t frames_received;
+    uint32_t handshake_frames;
+    uint32_t reads;
+    uint32_t unanswered_reads;
+    uint32_t writes;
+    uint32_t rejected_writes;
+    uint32_t time_syncs;
+    uint32_t checksum_errors;
+    uint32_t pushes;
+    uint32_t dropped_replies;
+    uint64_t bytes_received;
+    uint64_t bytes_sent;
+  };
+
+  ToshibaUnitSim() : ToshibaUnitSim(Config{}) {}
+  explicit ToshibaUnitSim(const Config &config);
+
+  /// Bytes written by the controller at now_us.
+  void receive(const uint8_t *data, size_t length, uint64_t now_us);
+  /// Number of reply bytes which arrived at the controller by now_us.
+  size_t available(uint64_t now_us);
+  /// Read at most length arrived bytes, returns the number of bytes read.
+  size_t read(uint8_t *data, size_t length, uint64_t now_us);
+  /// Time of the next byte arrival or push, for event loops sleeping until then. 0 when nothing is scheduled.
+  uint64_t next_event_us(uint64_t now_us);
+
+  /// Change a register as the IR remote does, optionally the unit reports the change on its own.
+  void set_register(uint8_t reg, uint8_t value, bool push, uint64_t now_us);
+  uint8_t get_register(uint8_t reg) const { return this->values_[reg]; }
+  void set_supported(uint8_t reg, bool supported);
+  bool is_supported(uint8_t reg) const { return this->supported_[reg / 32] & (1u << (reg % 32)); }
+
+  /// Time the last write of the register started to arrive, and the number of its writes.
+  uint64_t last_write_us(uint8_t reg) const { return this->last_write_us_[reg]; }
+  uint32_t write_count(uint8_t reg) const { return this->write_count_[reg]; }
+  const Stats &stats() const { return this->stats_; }
+
+  // registers modelled by the unit
+  static const uint8_t POWER_STATE = 128;
+  static const uint8_t POWER_SEL = 135;
+  static const uint8_t FAN = 160;
+  static const uint8_t SWING = 163;
+  static const uint8_t MODE = 176;
+  static const uint8_t TARGET_TEMP = 179;
+  static const uint8_t ROOM_TEMP = 187;
+  static const uint8_t OUTDOOR_TEMP = 190;
+  static const uint8_t SELF_CLEAN = 0xCB;
+  static const uint8_t ENERGY_DAILY = 0xD8;
+  static const uint8_t WIFI_LED_1 = 222;
+  static const uint8_t WIFI_LED_2 = 223;
+  static const uint8_t IDU_STATUS = 0xE4;
+  static const uint8_t ODU_STATUS = 0xE5;
+  static const uint8_t SPECIAL_MODE = 247;
+  static const uint8_t POWER_ON = 48;
+
+ protected:
+  static const uint8_t RX_MAX = 255;
+  static const uint8_t TX_FRAME_MAX = 72;
+  static const uint8_t TX_FRAMES = 16;
+
+  // reply waiting for the line, its bytes arrive one by one from start_us
+  struct TxFrame {
+    uint8_t data[TX_FRAME_MAX];
+    uint8_t length;
+    uint8_t read;
+    uint64_t start_us;
+  };
+
+  void handle_frame_(uint64_t end_us);
+  bool handle_handshake_byte_();
+  void reply_value_(uint8_t reg, uint64_t at_us);
+  void reply_ack_(bool time_sync, uint64_t at_us);
+  void reply_status_(uint8_t reg, uint64_t at_us);
+  void reply_energy_(uint64_t at_us);
+  void send_(const uint8_t *data, uint8_t length, uint64_t at_us);
+  void advance_(uint64_t now_us);
+  uint8_t hour_(uint64_t now_us) const;
+  uint32_t byte_us_() const { return 10000000 / this->config_.baud; }
+
+  Config config_;
+  Stats stats_{};
+  uint8_t values_[256]{};
+  uint32_t supported_[8]{};
+  uint64_t last_write_us_[256]{};
+  uint32_t write_count_[256]{};
+
+  uint8_t rx_[RX_MAX];
+  uint16_t rx_length_ = 0;
+  uint64_t rx_start_us_ = 0;
+
+  TxFrame tx_[TX_FRAMES];
+  uint8_t tx_head_ = 0;
+  uint8_t tx_count_ = 0;
+  // the line is busy with our reply until then
+  uint64_t tx_free_us_ = 0;
+
+  uint64_t next_push_us_ = 0;
+  uint64_t advanced_us_ = 0;
+  // seconds of the day at clock_set_us_, set by the time sync
+  uint32_t clock_seconds_ = 0;
+  uint64_t clock_set_us_ = 0;
+  uint8_t energy_hour_ = 0;
+  double energy_wh_[24]{};
+};
+
+}  // namespace toshiba_suzumi
+}  // namespace esphome
@@ -0,0 +1,112 @@
+// Per-unit memory and CPU cost of the component, see "Host tools" in README.md.
+//
+// Usage:
+//   toshiba_unit_cost [-n units] [-H hours] [-d reply_delay_ms] [-v]
+//
+// Runs a node of units against simulated units on the virtual clock: half of them heat, the others
+// are off, all of them report energy, IDU/ODU status and sync their time. The node starts and warms up
+// for a simulated hour, then it runs for the given hours. Prints one JSON object:
+//   instance_bytes            sizeof(ToshibaClimateUart) on this host (pointers are 8 bytes here, 4 on ESPs)
+//   heap_bytes_per_unit       heap taken by setup() and the warm-up, e.g. scheduler items and callbacks
+//   allocations_per_unit_hour heap allocations during the measured hours
+//   cpu_ms_per_unit_hour      CPU time of the node (component, scheduler and simulated unit) in the measured hours
+//   frames_per_unit_hour      frames sent by the component
+//   line_bytes_per_unit_hour  bytes on the line in both directions, to size serial bridges
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <unistd.h>
+#include <vector>
+#include "toshiba_alloc_count.h"
+#include "toshiba_host_unit.h"
+
+using namespace esphome;
+using namespace esphome::toshiba_suzumi;
+
+namespace {
+
+const uint32_t HOUR = 3600000;
+
+double thread_cpu_ms() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t units = 32;
+  uint32_t hours = 4;
+  ToshibaUnitSim::Config config;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:H:d:v")) != -1) {
+    switch (opt) {
+      case 'n':
+        units = strtoul(optarg, nullptr, 10);
+        break;
+      case 'H':
+        hours = strtoul(optarg, nullptr, 10);
+        break;
+      case 'd':
+        config.reply_delay_us = strtoul(optarg, nullptr, 10) * 1000;
+        break;
+      case 'v':
+        host::set_log_level(ESPHOME_LOG_LEVEL_DEBUG);
+        break;
+      default:
+        units = 0;
+    }
+  }
+  if (units == 0 || units > 255 || hours == 0) {
+    fprintf(stderr, "Usage: %s [-n units] [-H hours] [-d reply_delay_ms] [-v]\n", argv[0]);
+    return 2;
+  }
+
+  time::RealTimeClock clock;
+  clock.set_epoch(ToshibaHostUnit::EPOCH);
+  std::vector<std::unique_ptr<ToshibaHostUnit>> node;
+  for (uint32_t i = 0; i < units; i++) {
+    node.emplace_back(new ToshibaHostUnit(i, config, &clock, 30000));
+  }
+  auto before_setup = alloc_count::counters();
+  host::setup();
+  // all units are connected after their staggered setup
+  host::run_for(units * UNIT_SETUP_STAGGER + 10000);
+  for (uint32_t i = 0; i < units; i += 2) {
+    auto call = node[i]->climate.make_call();
+    call.set_mode(climate::CLIMATE_MODE_HEAT).set_target_temperature(23);
+    call.perform();
+  }
+  host::run_for(HOUR);
+  auto after_warmup = alloc_count::counters();
+
+  uint64_t frames = 0;
+  uint64_t line_bytes = 0;
+  for (auto &unit : node) {
+    frames -= unit->climate.get_link_stats().frames_sent;
+    line_bytes -= unit->sim.stats().bytes_received + unit->sim.stats().bytes_sent;
+  }
+  double cpu = thread_cpu_ms();
+  host::run_for(hours * HOUR);
+  cpu = thread_cpu_ms() - cpu;
+  auto after_run = alloc_count::counters();
+  uint32_t lost = 0;
+  for (auto &unit : node) {
+    frames += unit->climate.get_link_stats().frames_sent;
+    line_bytes += unit->sim.stats().bytes_received + unit->sim.stats().bytes_sent;
+    lost += unit->climate.is_link_lost();
+  }
+
+  double unit_hours = static_cast<double>(units) * hours;
+  printf("{\"units\":%u,\"hours\":%u,\"reply_delay_ms\":%u,\"instance_bytes\":%zu,\"heap_bytes_per_unit\":%lld,"
+         "\"allocations_per_unit_hour\":%.1f,\"cpu_ms_per_unit_hour\":%.2f,\"frames_per_unit_hour\":%.0f,"
+         "\"line_bytes_per_unit_hour\":%.0f,\"units_lost\":%u}\n",
+         units, hours, config.reply_delay_us / 1000, sizeof(ToshibaClimateUart),
+         (long long) (after_warmup.live_bytes - before_setup.live_bytes) / units,
+         (after_run.allocations - after_warmup.allocations) / unit_hours, cpu / unit_hours, frames / unit_hours,
+         line_bytes / unit_hours, lost);
+  return lost == 0 ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+// Simulated units served over TCP, like units behind RS-232-to-TCP bridges, see "Host tools" in README.md.
+//
+// Usage:
+//   toshiba_unit_sim [-a address] [-p first_port] [-n units] [-d reply_delay_ms] [-b baud] [-s status_interval_s] [-r]
+//
+// Unit N listens on first_port + N (default 127.0.0.1:6638), one client at a time, a new client replaces
+// the previous one. The replies are paced by the baud rate. -r makes the units reject packed writes.
+// Lines "<unit> <register> <value>" on stdin change a register as the IR remote does, the unit reports
+// the change. All sockets and stdin are served by one epoll loop.
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "toshiba_sim.h"
+
+using namespace esphome::toshiba_suzumi;
+
+namespace {
+
+struct Unit {
+  ToshibaUnitSim sim;
+  int listen_fd;
+  int client_fd;
+};
+
+uint64_t now_us() {
+  static auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int listen_on(const char *address, uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, address, &addr.sin_addr) != 1 || bind(fd, (sockaddr *) &addr, sizeof(addr)) != 0 ||
+      listen(fd, 1) != 0) {
+    fprintf(stderr, "Can't listen on %s:%u: %s\n", address, port, strerror(errno));
+    exit(1);
+  }
+  return fd;
+}
+
+void close_client(Unit &unit, int epoll_fd, size_t index) {
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, unit.client_fd, nullptr);
+  close(unit.client_fd);
+  unit.client_fd = -1;
+  fprintf(stderr, "unit %zu: client disconnected\n", index);
+}
+
+// "<unit> <register> <value>"
+void handle_command(std::vector<Unit> &units, char *line) {
+  unsigned index, reg, value;
+  if (sscanf(line, "%u %u %u", &index, &reg, &value) != 3 || index >= units.size() || reg > 255 || value > 255) {
+    fprintf(stderr, "Expected: <unit> <register> <value>\n");
+    return;
+  }
+  units[index].sim.set_register(reg, value, true, now_us());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const char *address = "127.0.0.1";
+  uint16_t first_port = 6638;
+  uint32_t count = 1;
+  ToshibaUnitSim::Config config;
+  int opt;
+  while ((opt = getopt(argc, argv, "a:p:n:d:b:s:r")) != -1) {
+    switch (opt) {
+      case 'a':
+        address = optarg;
+        break;
+      case 'p':
+        first_port = strtoul(optarg, nullptr, 10);
+        break;
+      case 'n':
+        count = strtoul(optarg, nullptr, 10);
+        break;
+      case 'd':
+        config.reply_delay_us = strtoul(optarg, nullptr, 10) * 1000;
+        break;
+      case 'b':
+        config.baud = strtoul(optarg, nullptr, 10);
+        break;
+      case 's':
+        config.status_interval_ms = strtoul(optarg, nullptr, 10) * 1000;
+        break;
+      case 'r':
+        config.packed_writes = false;
+        break;
+      default:
+        count = 0;
+    }
+  }
+  if (count == 0 || config.baud == 0) {
+    fprintf(stderr,
+            "Usage: %s [-a address] [-p first_port] [-n units] [-d reply_delay_ms] [-b baud] [-s status_interval_s] "
+            "[-r]\n",
+            argv[0]);
+    return 2;
+  }
+
+  int epoll_fd = epoll_create1(0);
+  // the index of the unit in the event data, listening sockets after the clients, stdin last
+  std::vector<Unit> units(count, Unit{ToshibaUnitSim(config), -1, -1});
+  epoll_event event{};
+  for (uint32_t i = 0; i < count; i++) {
+    units[i].listen_fd = listen_on(address, first_port + i);
+    event.events = EPOLLIN;
+    event.data.u64 = count + i;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, units[i].listen_fd, &event);
+  }
+  event.events = EPOLLIN;
+  event.data.u64 = 2 * count;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, STDIN_FILENO, &event);
+  fprintf(stderr, "%u simulated units on %s:%u-%u\n", count, address, first_port, first_port + count - 1);
+
+  epoll_event events[16];
+  uint8_t buffer[512];
+  char line[128];
+  size_t line_length = 0;
+  while (true) {
+    // sleep until the next reply byte arrives or the next push
+    uint64_t now = now_us();
+    uint64_t next = now + 1000000;
+    for (auto &unit : units) {
+      uint64_t at = unit.sim.next_event_us(now);
+      if (at != 0 && at < next) {
+        next = at;
+      }
+    }
+    int timeout = next > now ? (next - now + 999) / 1000 : 0;
+    int ready = epoll_wait(epoll_fd, events, 16, timeout);
+    if (ready < 0 && errno != EINTR) {
+      perror("epoll_wait");
+      return 1;
+    }
+    for (int e = 0; e < ready; e++) {
+      uint64_t index = events[e].data.u64;
+      if (index == 2 * count) {
+        ssize_t n = read(STDIN_FILENO, line + line_length, sizeof(line) - 1 - line_length);
+        if (n <= 0) {
+          epoll_ctl(epoll_fd, EPOLL_CTL_DEL, STDIN_FILENO, nullptr);
+          continue;
+        }
+        line_length += n;
+        char *end;
+        while ((end = static_cast<char *>(memchr(line, '\n', line_length))) != nullptr) {
+          *end = '\0';
+          handle_command(units, line);
+          line_length -= end + 1 - line;
+          memmove(line, end + 1, line_length);
+        }
+        if (line_length == sizeof(line) - 1) {
+          line_length = 0;
+        }
+      } else if (index >= count) {
+        auto &unit = units[index - count];
+        int fd = accept4(unit.listen_fd, nullptr, nullptr, SOCK_NONBLOCK);
+        if (fd < 0) {
+          continue;
+        }
+        if (unit.client_fd >= 0) {
+          close_client(unit, epoll_fd, index - count);
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        unit.client_fd = fd;
+        event.events = EPOLLIN;
+        event.data.u64 = index - count;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        fprintf(stderr, "unit %lu: client connected\n", (unsigned long) (index - count));
+      } else {
+        auto &unit = units[index];
+        ssize_t n = read(unit.client_fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+          close_client(unit, epoll_fd, index);
+          continue;
+        }
+        unit.sim.receive(buffer, n, now_us());
+      }
+    }
+    // arrived reply bytes go to the client, without one they are lost like on an unconnected line
+    now = now_us();
+    for (size_t i = 0; i < units.size(); i++) {
+      auto &unit = units[i];
+      size_t n;
+      while ((n = unit.sim.read(buffer, sizeof(buffer), now)) > 0) {
+        if (unit.client_fd >= 0 && send(unit.client_fd, buffer, n, MSG_NOSIGNAL) < 0 && errno != EAGAIN) {
+          close_client(unit, epoll_fd, i);
+        }
+      }
+    }
+  }
+}